@@ -49,7 +49,6 @@ static void emutls_shutdown(emutls_address_array *array);
 
 #include <pthread.h>
 
-static pthread_mutex_t emutls_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_key_t emutls_pthread_key;
 static bool emutls_key_created = false;
 
@@ -125,10 +124,6 @@ static __inline void emutls_init_once(void) {
   pthread_once(&once, emutls_init);
 }
 
-static __inline void emutls_lock() { pthread_mutex_lock(&emutls_mutex); }
-
-static __inline void emutls_unlock() { pthread_mutex_unlock(&emutls_mutex); }
-
 #else // _WIN32
 
 #include <assert.h>
@@ -136,7 +131,6 @@ static __inline void emutls_unlock() { pthread_mutex_unlock(&emutls_mutex); }
 #include <stdio.h>
 #include <windows.h>
 
-static LPCRITICAL_SECTION emutls_mutex;
 static DWORD emutls_tls_index = TLS_OUT_OF_INDEXES;
 
 typedef uintptr_t gcc_word;
@@ -170,11 +164,6 @@ static __inline void *emutls_memalign_alloc(size_t align, size_t size) {
 static __inline void emutls_memalign_free(void *base) { _aligned_free(base); }
 
 static void emutls_exit(void) {
-  if (emutls_mutex) {
-    DeleteCriticalSection(emutls_mutex);
-    _aligned_free(emutls_mutex);
-    emutls_mutex = NULL;
-  }
   if (emutls_tls_index != TLS_OUT_OF_INDEXES) {
     emutls_shutdown((emutls_address_array *)TlsGetValue(emutls_tls_index));
     TlsFree(emutls_tls_index);
@@ -185,14 +174,6 @@ static void emutls_exit(void) {
 #pragma warning(push)
 #pragma warning(disable : 4100)
 static BOOL CALLBACK emutls_init(PINIT_ONCE p0, PVOID p1, PVOID *p2) {
-  emutls_mutex =
-      (LPCRITICAL_SECTION)_aligned_malloc(sizeof(CRITICAL_SECTION), 16);
-  if (!emutls_mutex) {
-    win_error(GetLastError(), "_aligned_malloc");
-    return FALSE;
-  }
-  InitializeCriticalSection(emutls_mutex);
-
   emutls_tls_index = TlsAlloc();
   if (emutls_tls_index == TLS_OUT_OF_INDEXES) {
     emutls_exit();
@@ -208,10 +189,6 @@ static __inline void emutls_init_once(void) {
   InitOnceExecuteOnce(&once, emutls_init, NULL, NULL);
 }
 
-static __inline void emutls_lock() { EnterCriticalSection(emutls_mutex); }
-
-static __inline void emutls_unlock() { LeaveCriticalSection(emutls_mutex); }
-
 static __inline void emutls_setspecific(emutls_address_array *value) {
   if (TlsSetValue(emutls_tls_index, (LPVOID)value) == 0)
     win_abort(GetLastError(), "TlsSetValue");
@@ -227,11 +204,12 @@ static __inline emutls_address_array *emutls_getspecific() {
   return (emutls_address_array *)value;
 }
 
-// Provide atomic load/store functions for emutls_get_index if built with MSVC.
+// Provide atomic functions for emutls_get_index if built with MSVC.
 #if !defined(__ATOMIC_RELEASE)
 #include <intrin.h>
 
-enum { __ATOMIC_ACQUIRE = 2, __ATOMIC_RELEASE = 3 };
+enum { __ATOMIC_RELAXED = 0, __ATOMIC_ACQUIRE = 2, __ATOMIC_RELEASE = 3,
+       __ATOMIC_ACQ_REL = 4 };
 
 static __inline uintptr_t __atomic_load_n(void *ptr, unsigned type) {
   assert(type == __ATOMIC_ACQUIRE);
@@ -249,13 +227,35 @@ static __inline void __atomic_store_n(void *ptr, uintptr_t val, unsigned type) {
   InterlockedExchangePointer((void *volatile *)ptr, (void *)val);
 }
 
+static __inline uintptr_t __atomic_add_fetch(void *ptr, uintptr_t val,
+                                             unsigned type) {
+  // Interlocked operations are full barriers, whatever the requested order.
+#ifdef _WIN64
+  return InterlockedExchangeAdd64(ptr, val) + val;
+#else
+  return InterlockedExchangeAdd(ptr, val) + val;
+#endif
+}
+
+static __inline bool __atomic_compare_exchange_n(void *ptr, uintptr_t *expected,
+                                                 uintptr_t desired, bool weak,
+                                                 unsigned success,
+                                                 unsigned failure) {
+  uintptr_t prev = (uintptr_t)InterlockedCompareExchangePointer(
+      (void *volatile *)ptr, (void *)desired, (void *)*expected);
+  if (prev == *expected)
+    return true;
+  *expected = prev;
+  return false;
+}
+
 #endif // __ATOMIC_RELEASE
 
 #pragma warning(pop)
 
 #endif // _WIN32
 
-static size_t emutls_num_object = 0; // number of allocated TLS objects
+static uintptr_t emutls_num_object = 0; // number of allocated TLS indices
 
 // Free the allocated TLS data
 static void emutls_shutdown(emutls_address_array *array) {
@@ -310,17 +310,20 @@ static __inline void *emutls_allocate_object(__emutls_control *control) {
 }
 
 // Returns control->object.index; set index if not allocated yet.
+// Indices are handed out from a global counter and published with a CAS, so
+// that first accesses to different variables do not serialize on a lock. When
+// several threads race on the same control, the indices of the losers are
+// simply left unused.
 static __inline uintptr_t emutls_get_index(__emutls_control *control) {
   uintptr_t index = __atomic_load_n(&control->object.index, __ATOMIC_ACQUIRE);
   if (!index) {
+    uintptr_t expected = 0;
     emutls_init_once();
-    emutls_lock();
-    index = control->object.index;
-    if (!index) {
-      index = ++emutls_num_object;
-      __atomic_store_n(&control->object.index, index, __ATOMIC_RELEASE);
-    }
-    emutls_unlock();
+    index = __atomic_add_fetch(&emutls_num_object, 1, __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&control->object.index, &expected, index,
+                                     false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+      index = expected;
   }
   return index;
 }
@@ -344,6 +347,16 @@ static __inline uintptr_t emutls_new_data_array_size(uintptr_t index) {
   return ((index + header_words + 15) & ~((uintptr_t)15)) - header_words;
 }
 
+// Returns the size of an array growing from orig_size elements to hold index.
+// The array at least doubles, so that a thread touching many variables in
+// turn reallocates it a logarithmic number of times.
+static __inline uintptr_t emutls_grown_data_array_size(uintptr_t orig_size,
+                                                       uintptr_t index) {
+  if (index < 2 * orig_size)
+    index = 2 * orig_size;
+  return emutls_new_data_array_size(index);
+}
+
 // Returns the size in bytes required for an emutls_address_array with
 // N number of elements for data field.
 static __inline uintptr_t emutls_asize(uintptr_t N) {
@@ -365,7 +378,7 @@ emutls_get_address_array(uintptr_t index) {
     emutls_check_array_set_size(array, new_size);
   } else if (index > array->size) {
     uintptr_t orig_size = array->size;
-    uintptr_t new_size = emutls_new_data_array_size(index);
+    uintptr_t new_size = emutls_grown_data_array_size(orig_size, index);
     array = (emutls_address_array *)realloc(array, emutls_asize(new_size));
     if (array)
       memset(array->data + orig_size, 0,
@@ -375,7 +388,9 @@ emutls_get_address_array(uintptr_t index) {
   return array;
 }
 
-void *__emutls_get_address(__emutls_control *control) {
+// Allocates the index of the variable, grows the array of the thread and
+// allocates the object of the thread as needed.
+static NOINLINE void *emutls_get_address_slow(__emutls_control *control) {
   uintptr_t index = emutls_get_index(control);
   emutls_address_array *array = emutls_get_address_array(index--);
   if (array->data[index] == NULL)
@@ -383,6 +398,18 @@ void *__emutls_get_address(__emutls_control *control) {
   return array->data[index];
 }
 
+void *__emutls_get_address(__emutls_control *control) {
+  // Once the object of the thread exists, this is a couple of loads besides
+  // the lookup of the array of the thread.
+  uintptr_t index = __atomic_load_n(&control->object.index, __ATOMIC_ACQUIRE);
+  if (index) {
+    emutls_address_array *array = emutls_getspecific();
+    if (array && index <= array->size && array->data[index - 1])
+      return array->data[index - 1];
+  }
+  return emutls_get_address_slow(control);
+}
+
 #ifdef __BIONIC__
 // Called by Bionic on dlclose to delete the emutls pthread key.
 __attribute__((visibility("hidden"))) void __emutls_unregister_key(void) {
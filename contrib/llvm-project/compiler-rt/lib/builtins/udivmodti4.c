@@ -98,7 +98,6 @@ static inline du_int udiv128by64to64(du_int u1, du_int u0, du_int v,
 // Returns: a / b
 
 COMPILER_RT_ABI tu_int __udivmodti4(tu_int a, tu_int b, tu_int *rem) {
-  const unsigned n_utword_bits = sizeof(tu_int) * CHAR_BIT;
   utwords dividend;
   dividend.all = a;
   utwords divisor;
@@ -130,28 +129,32 @@ COMPILER_RT_ABI tu_int __udivmodti4(tu_int a, tu_int b, tu_int *rem) {
       *rem = remainder.all;
     return quotient.all;
   }
+  // The divisor has bits in its high half, so the quotient fits in 64 bits.
+  // Divide the halved dividend by the top 64 bits of the normalized divisor,
+  // which cannot overflow, and scale the result back: this underestimates the
+  // quotient by at most one (see Hacker's Delight, section 9-5, divlu2).
   // 0 <= shift <= 63.
-  si_int shift =
-      __builtin_clzll(divisor.s.high) - __builtin_clzll(dividend.s.high);
-  divisor.all <<= shift;
-  quotient.s.high = 0;
-  quotient.s.low = 0;
-  for (; shift >= 0; --shift) {
-    quotient.s.low <<= 1;
-    // Branch free version of.
-    // if (dividend.all >= divisor.all)
-    // {
-    //    dividend.all -= divisor.all;
-    //    carry = 1;
-    // }
-    const ti_int s =
-        (ti_int)(divisor.all - dividend.all - 1) >> (n_utword_bits - 1);
-    quotient.s.low |= s & 1;
-    dividend.all -= divisor.all & s;
-    divisor.all >>= 1;
+  si_int shift = __builtin_clzll(divisor.s.high);
+  utwords normalized_divisor;
+  normalized_divisor.all = divisor.all << shift;
+  utwords halved_dividend;
+  halved_dividend.all = dividend.all >> 1;
+  du_int unused;
+  du_int q = udiv128by64to64(halved_dividend.s.high, halved_dividend.s.low,
+                             normalized_divisor.s.high, &unused);
+  q >>= 63 - shift;
+  // Make the estimate too small by zero or one, then correct it.
+  if (q != 0)
+    --q;
+  remainder.all = dividend.all - (tu_int)q * divisor.all;
+  if (remainder.all >= divisor.all) {
+    ++q;
+    remainder.all -= divisor.all;
   }
   if (rem)
-    *rem = dividend.all;
+    *rem = remainder.all;
+  quotient.s.high = 0;
+  quotient.s.low = q;
   return quotient.all;
 }
 
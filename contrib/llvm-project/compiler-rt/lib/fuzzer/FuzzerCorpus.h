@@ -11,6 +11,7 @@
 #ifndef LLVM_FUZZER_CORPUS
 #define LLVM_FUZZER_CORPUS
 
+#include "FuzzerCorpusStore.h"
 #include "FuzzerDataFlowTrace.h"
 #include "FuzzerDefs.h"
 #include "FuzzerIO.h"
@@ -25,7 +26,10 @@
 namespace fuzzer {
 
 struct InputInfo {
-  Unit U;  // The actual input data.
+  Unit U;  // The actual input data, unless it is kept in the CorpusStore.
+  // The input data in the CorpusStore, if any. U is empty then.
+  const uint8_t *StoredData = nullptr;
+  size_t StoredSize = 0;
   uint8_t Sha1[kSHA1NumBytes];  // Checksum.
   // Number of features that this input has and no smaller input has.
   size_t NumFeatures = 0;
@@ -44,6 +48,26 @@ struct InputInfo {
   size_t SumIncidence = 0;
   Vector<std::pair<uint32_t, uint16_t>> FeatureFreqs;
 
+  const uint8_t *Data() const { return StoredData ? StoredData : U.data(); }
+  size_t Size() const { return StoredData ? StoredSize : U.size(); }
+  bool Empty() const { return Size() == 0; }
+
+  // Sha1 must be set already.
+  void SetData(const uint8_t *Data, size_t Size, CorpusStore *Store) {
+    StoredData = Store ? Store->Add(Data, Size, Sha1) : nullptr;
+    StoredSize = StoredData ? Size : 0;
+    if (StoredData)
+      Unit().swap(U);
+    else
+      U.assign(Data, Data + Size);
+  }
+
+  void ClearData() {
+    Unit().swap(U);
+    StoredData = nullptr;
+    StoredSize = 0;
+  }
+
   // Delete feature Idx and its frequency from FeatureFreqs.
   bool DeleteFeatureFreq(uint32_t Idx) {
     if (FeatureFreqs.empty())
@@ -145,23 +169,27 @@ class InputCorpus {
   size_t SizeInBytes() const {
     size_t Res = 0;
     for (auto II : Inputs)
-      Res += II->U.size();
+      Res += II->Size();
     return Res;
   }
   size_t NumActiveUnits() const {
     size_t Res = 0;
     for (auto II : Inputs)
-      Res += !II->U.empty();
+      Res += !II->Empty();
     return Res;
   }
   size_t MaxInputSize() const {
     size_t Res = 0;
     for (auto II : Inputs)
-        Res = std::max(Res, II->U.size());
+        Res = std::max(Res, II->Size());
     return Res;
   }
   void IncrementNumExecutedMutations() { NumExecutedMutations++; }
 
+  // Keep the inputs in Store rather than on the heap.
+  void SetStore(CorpusStore *S) { Store = S; }
+  CorpusStore *GetStore() const { return Store; }
+
   size_t NumInputsThatTouchFocusFunction() {
     return std::count_if(Inputs.begin(), Inputs.end(), [](const InputInfo *II) {
       return II->HasFocusFunction;
@@ -175,7 +203,6 @@ class InputCorpus {
   }
 
   bool empty() const { return Inputs.empty(); }
-  const Unit &operator[] (size_t Idx) const { return Inputs[Idx]->U; }
   InputInfo *AddToCorpus(const Unit &U, size_t NumFeatures, bool MayDeleteFile,
                          bool HasFocusFunction,
                          const Vector<uint32_t> &FeatureSet,
@@ -185,7 +212,6 @@ class InputCorpus {
       Printf("ADD_TO_CORPUS %zd NF %zd\n", Inputs.size(), NumFeatures);
     Inputs.push_back(new InputInfo());
     InputInfo &II = *Inputs.back();
-    II.U = U;
     II.NumFeatures = NumFeatures;
     II.MayDeleteFile = MayDeleteFile;
     II.UniqFeatureSet = FeatureSet;
@@ -196,6 +222,7 @@ class InputCorpus {
     II.NeedsEnergyUpdate = false;
     std::sort(II.UniqFeatureSet.begin(), II.UniqFeatureSet.end());
     ComputeSHA1(U.data(), U.size(), II.Sha1);
+    II.SetData(U.data(), U.size(), Store);
     auto Sha1Str = Sha1ToString(II.Sha1);
     Hashes.insert(Sha1Str);
     if (HasFocusFunction)
@@ -237,10 +264,11 @@ class InputCorpus {
     Printf("======= CORPUS:\n");
     int i = 0;
     for (auto II : Inputs) {
-      if (std::find(II->U.begin(), II->U.end(), 'F') != II->U.end()) {
+      if (std::find(II->Data(), II->Data() + II->Size(), 'F') !=
+          II->Data() + II->Size()) {
         Printf("[%2d] ", i);
-        Printf("%s sz=%zd ", Sha1ToString(II->Sha1).c_str(), II->U.size());
-        PrintUnit(II->U);
+        Printf("%s sz=%zd ", Sha1ToString(II->Sha1).c_str(), II->Size());
+        PrintUnit({II->Data(), II->Data() + II->Size()});
         Printf(" ");
         PrintFeatureSet(II->UniqFeatureSet);
         Printf("\n");
@@ -250,12 +278,14 @@ class InputCorpus {
   }
 
   void Replace(InputInfo *II, const Unit &U) {
-    assert(II->U.size() > U.size());
+    assert(II->Size() > U.size());
     Hashes.erase(Sha1ToString(II->Sha1));
     DeleteFile(*II);
+    if (Store)
+      Store->Remove(II->Sha1);
     ComputeSHA1(U.data(), U.size(), II->Sha1);
     Hashes.insert(Sha1ToString(II->Sha1));
-    II->U = U;
+    II->SetData(U.data(), U.size(), Store);
     II->Reduced = true;
     DistributionNeedsUpdate = true;
   }
@@ -264,7 +294,7 @@ class InputCorpus {
   bool HasUnit(const std::string &H) { return Hashes.count(H); }
   InputInfo &ChooseUnitToMutate(Random &Rand) {
     InputInfo &II = *Inputs[ChooseUnitIdxToMutate(Rand)];
-    assert(!II.U.empty());
+    assert(!II.Empty());
     return II;
   }
 
@@ -280,7 +310,7 @@ class InputCorpus {
     for (size_t i = 0; i < Inputs.size(); i++) {
       const auto &II = *Inputs[i];
       Printf("  [% 3zd %s] sz: % 5zd runs: % 5zd succ: % 5zd focus: %d\n", i,
-             Sha1ToString(II.Sha1).c_str(), II.U.size(),
+             Sha1ToString(II.Sha1).c_str(), II.Size(),
              II.NumExecutedMutations, II.NumSuccessfullMutations, II.HasFocusFunction);
     }
   }
@@ -305,7 +335,9 @@ class InputCorpus {
   void DeleteInput(size_t Idx) {
     InputInfo &II = *Inputs[Idx];
     DeleteFile(II);
-    Unit().swap(II.U);
+    if (Store)
+      Store->Remove(II.Sha1);
+    II.ClearData();
     II.Energy = 0.0;
     II.NeedsEnergyUpdate = false;
     DistributionNeedsUpdate = true;
@@ -526,6 +558,7 @@ class InputCorpus {
   Vector<uint32_t> RareFeatures;
 
   std::string OutputCorpus;
+  CorpusStore *Store = nullptr;
 };
 
 }  // namespace fuzzer
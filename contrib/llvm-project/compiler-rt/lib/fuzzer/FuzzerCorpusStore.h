@@ -0,0 +1,233 @@
+//===- FuzzerCorpusStore.h - On-disk store for corpus inputs ----*- C++ -* ===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+// fuzzer::CorpusStore
+//
+// Keeps the bytes of the inputs of the in-memory corpus in a single data file
+// mapped in memory, instead of on the heap. The pages of inputs that are not
+// being mutated can be written back and evicted by the OS, so large corpora
+// do not need to fit in RAM.
+//
+// The data file is append-only. Next to it, an index file records, for every
+// input, its SHA1, its offset and its size, as well as the inputs removed from
+// the corpus. When the store is reopened, only the index is read: the inputs
+// are executed straight from the mapped data file, and the files named after
+// their SHA1 in the corpus directories do not need to be read again.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_FUZZER_CORPUS_STORE_H
+#define LLVM_FUZZER_CORPUS_STORE_H
+
+#include "FuzzerDefs.h"
+#include "FuzzerIO.h"
+#include "FuzzerSHA1.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace fuzzer {
+
+class CorpusStore {
+public:
+  struct Entry {
+    uint8_t Sha1[kSHA1NumBytes];
+    uint64_t Offset;
+    uint64_t Size;
+    // Whether the entry was added to the corpus again in this session.
+    bool Used;
+  };
+
+  ~CorpusStore() {
+    if (IndexFile)
+      fclose(IndexFile);
+    for (auto &S : Segments)
+      UnmapSharedFile(S.Base, S.Size);
+  }
+
+  // Opens the store in Dir, creating it if needed, and loads its index.
+  bool Open(const std::string &Dir) {
+    MkDir(Dir);  // Fails harmlessly if Dir exists.
+    DataPath = DirPlusFile(Dir, "corpus.data");
+    auto IndexPath = DirPlusFile(Dir, "corpus.idx");
+
+    auto Index = FileToVector(IndexPath, 0, /*ExitOnError=*/false);
+    if (Index.size() % sizeof(IndexRecord))
+      Index.resize(Index.size() - Index.size() % sizeof(IndexRecord));
+    uint64_t DataSize = 0;
+    for (size_t Pos = 0; Pos < Index.size(); Pos += sizeof(IndexRecord)) {
+      IndexRecord R;
+      memcpy(&R, Index.data() + Pos, sizeof(R));
+      auto Key = Sha1ToString(R.Sha1);
+      auto It = EntryBySha1.find(Key);
+      if (R.Flags & kRecordRemoved) {
+        if (It != EntryBySha1.end())
+          Live[It->second] = false;
+        continue;
+      }
+      DataSize = Max(DataSize, R.Offset + R.Size);
+      if (It != EntryBySha1.end()) {
+        Live[It->second] = true;
+        continue;
+      }
+      Entry E;
+      memcpy(E.Sha1, R.Sha1, kSHA1NumBytes);
+      E.Offset = R.Offset;
+      E.Size = R.Size;
+      E.Used = false;
+      EntryBySha1[Key] = Entries.size();
+      Entries.push_back(E);
+      Live.push_back(true);
+    }
+
+    // Existing inputs are all in a first segment, new ones go after it.
+    if (DataSize && !MapSegment(0, RoundUpToMapping(DataSize)))
+      return false;
+    WritePos = RoundUpToMapping(DataSize);
+    IndexFile = fopen(IndexPath.c_str(), "ab");
+    return IndexFile != nullptr;
+  }
+
+  // The inputs the store contained when it was opened, and not removed since.
+  template <class Callback> // void Callback(const Entry &E, const uint8_t *Data)
+  void ForEachLiveEntry(Callback CB) {
+    for (size_t i = 0; i < Entries.size(); i++)
+      if (Live[i])
+        CB(Entries[i], Get(Entries[i].Offset));
+  }
+
+  bool Contains(const std::string &Sha1Str) {
+    auto It = EntryBySha1.find(Sha1Str);
+    return It != EntryBySha1.end() && Live[It->second];
+  }
+
+  // Returns a pointer to a copy of Data in the store, which remains valid for
+  // the lifetime of the store.
+  const uint8_t *Add(const uint8_t *Data, size_t Size,
+                     const uint8_t Sha1[kSHA1NumBytes]) {
+    auto Key = Sha1ToString(Sha1);
+    auto It = EntryBySha1.find(Key);
+    if (It != EntryBySha1.end() && Entries[It->second].Size == Size) {
+      Entry &E = Entries[It->second];
+      E.Used = true;
+      if (!Live[It->second]) {
+        Live[It->second] = true;
+        WriteRecord(E.Sha1, E.Offset, E.Size, 0);
+      }
+      return Get(E.Offset);
+    }
+    uint8_t *Dst = Allocate(Size);
+    if (!Dst)
+      return nullptr;
+    memcpy(Dst, Data, Size);
+    Entry E;
+    memcpy(E.Sha1, Sha1, kSHA1NumBytes);
+    E.Offset = WritePos - Size;
+    E.Size = Size;
+    E.Used = true;
+    EntryBySha1[Key] = Entries.size();
+    Entries.push_back(E);
+    Live.push_back(true);
+    WriteRecord(E.Sha1, E.Offset, E.Size, 0);
+    return Dst;
+  }
+
+  // Records that the input is not part of the corpus anymore. Its bytes stay
+  // in the data file (and mapped) until the store is recreated.
+  void Remove(const uint8_t Sha1[kSHA1NumBytes]) {
+    auto It = EntryBySha1.find(Sha1ToString(Sha1));
+    if (It == EntryBySha1.end() || !Live[It->second])
+      return;
+    Live[It->second] = false;
+    WriteRecord(Entries[It->second].Sha1, 0, 0, kRecordRemoved);
+  }
+
+  // Removes the inputs loaded from the index that did not make it into the
+  // corpus again, e.g. because they no longer add coverage.
+  void RemoveUnused() {
+    for (size_t i = 0; i < Entries.size(); i++)
+      if (Live[i] && !Entries[i].Used)
+        Remove(Entries[i].Sha1);
+  }
+
+private:
+  struct IndexRecord {
+    uint8_t Sha1[kSHA1NumBytes];
+    uint32_t Flags;
+    uint64_t Offset;
+    uint64_t Size;
+  };
+  static const uint32_t kRecordRemoved = 1;
+
+  struct Segment {
+    uint8_t *Base;
+    uint64_t Offset, Size;
+  };
+  // New segments are mapped by chunks of this size, or larger for inputs
+  // that do not fit.
+  static const uint64_t kSegmentSize = 1 << 26;
+  // Mappings start at multiples of this, which suits all platforms.
+  static const uint64_t kMappingGranularity = 1 << 16;
+
+  static uint64_t RoundUpToMapping(uint64_t X) {
+    return (X + kMappingGranularity - 1) & ~(kMappingGranularity - 1);
+  }
+
+  bool MapSegment(uint64_t Offset, uint64_t Size) {
+    void *Base = MapSharedFile(DataPath, Size, Offset);
+    if (!Base)
+      return false;
+    Segments.push_back({static_cast<uint8_t *>(Base), Offset, Size});
+    return true;
+  }
+
+  uint8_t *Get(uint64_t Offset) {
+    for (auto &S : Segments)
+      if (Offset >= S.Offset && Offset < S.Offset + S.Size)
+        return S.Base + (Offset - S.Offset);
+    assert(0 && "Offset out of the mapped segments");
+    return nullptr;
+  }
+
+  // Returns Size bytes at WritePos and advances it.
+  uint8_t *Allocate(size_t Size) {
+    if (Segments.empty() || WritePos + Size > Segments.back().Offset +
+                                                  Segments.back().Size) {
+      uint64_t Offset = RoundUpToMapping(WritePos);
+      if (!MapSegment(Offset, Max(kSegmentSize, RoundUpToMapping(Size))))
+        return nullptr;
+      WritePos = Offset;
+    }
+    uint8_t *Res = Get(WritePos);
+    WritePos += Size;
+    return Res;
+  }
+
+  void WriteRecord(const uint8_t Sha1[kSHA1NumBytes], uint64_t Offset,
+                   uint64_t Size, uint32_t Flags) {
+    IndexRecord R;
+    memcpy(R.Sha1, Sha1, kSHA1NumBytes);
+    R.Flags = Flags;
+    R.Offset = Offset;
+    R.Size = Size;
+    fwrite(&R, sizeof(R), 1, IndexFile);
+    fflush(IndexFile);
+  }
+
+  std::string DataPath;
+  FILE *IndexFile = nullptr;
+  Vector<Segment> Segments;
+  uint64_t WritePos = 0;
+  Vector<Entry> Entries;
+  Vector<bool> Live;
+  // Indices in Entries, by SHA1 string.
+  std::unordered_map<std::string, size_t> EntryBySha1;
+};
+
+}  // namespace fuzzer
+
+#endif  // LLVM_FUZZER_CORPUS_STORE_H
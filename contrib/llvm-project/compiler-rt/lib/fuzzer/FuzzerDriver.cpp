@@ -705,6 +705,10 @@ int FuzzerDriver(int *argc, char ***argv, UserCallback Callback) {
     Options.DataFlowTrace = Flags.data_flow_trace;
   if (Flags.features_dir)
     Options.FeaturesDir = Flags.features_dir;
+  if (Flags.fork_channel)
+    Options.ForkChannel = Flags.fork_channel;
+  if (Flags.corpus_store)
+    Options.CorpusStore = Flags.corpus_store;
   if (Flags.collect_data_flow)
     Options.CollectDataFlow = Flags.collect_data_flow;
   if (Flags.stop_file)
@@ -750,6 +754,15 @@ int FuzzerDriver(int *argc, char ***argv, UserCallback Callback) {
   Random Rand(Seed);
   auto *MD = new MutationDispatcher(Rand, Options);
   auto *Corpus = new InputCorpus(Options.OutputCorpus, Entropic);
+  if (!Options.CorpusStore.empty()) {
+    auto *Store = new CorpusStore;
+    if (!Store->Open(Options.CorpusStore)) {
+      Printf("ERROR: failed to open the corpus store in %s\n",
+             Options.CorpusStore.c_str());
+      exit(1);
+    }
+    Corpus->SetStore(Store);
+  }
   auto *F = new Fuzzer(Callback, *Corpus, *MD, Options);
 
   for (auto &U: Dictionary)
@@ -61,6 +61,25 @@ static Stats ParseFinalStatsFromLog(const std::string &LogPath) {
   return Res;
 }
 
+ForkChannel *MapForkChannel(const std::string &Path) {
+  return static_cast<ForkChannel *>(MapSharedFile(Path, sizeof(ForkChannel)));
+}
+
+void UnmapForkChannel(ForkChannel *Channel) {
+  if (Channel)
+    UnmapSharedFile(Channel, sizeof(ForkChannel));
+}
+
+static Stats ReadStatsFromChannel(const ForkChannel &Channel) {
+  Stats Res;
+  Res.number_of_executed_units =
+      Channel.NumberOfExecutedUnits.load(std::memory_order_relaxed);
+  Res.peak_rss_mb = Channel.PeakRssMb.load(std::memory_order_relaxed);
+  Res.average_exec_per_sec =
+      Channel.AverageExecPerSec.load(std::memory_order_relaxed);
+  return Res;
+}
+
 struct FuzzJob {
   // Inputs.
   Command Cmd;
@@ -69,6 +88,8 @@ struct FuzzJob {
   std::string LogPath;
   std::string SeedListPath;
   std::string CFPath;
+  std::string ChannelPath;
+  ForkChannel *Channel = nullptr;
   size_t      JobId;
 
   int         DftTimeInSeconds = 0;
@@ -77,6 +98,8 @@ struct FuzzJob {
   int ExitCode;
 
   ~FuzzJob() {
+    UnmapForkChannel(Channel);
+    RemoveFile(ChannelPath);
     RemoveFile(CFPath);
     RemoveFile(LogPath);
     RemoveFile(SeedListPath);
@@ -93,6 +116,9 @@ struct GlobalEnv {
   std::string DFTDir;
   std::string DataFlowBinary;
   Set<uint32_t> Features, Cov;
+  // Features as a bitmap, in the same format as ForkChannel::Features.
+  Vector<uint64_t> FeatureBits =
+      Vector<uint64_t>(ForkChannel::kNumFeatureBits / 64);
   Set<std::string> FilesWithDFT;
   Vector<std::string> Files;
   Random *Rand;
@@ -108,6 +134,25 @@ struct GlobalEnv {
 
   std::string StopFile() { return DirPlusFile(TempDir, "STOP"); }
 
+  void AddFeatures(const Set<uint32_t> &NewFeatures) {
+    Features.insert(NewFeatures.begin(), NewFeatures.end());
+    for (auto Ft : NewFeatures) {
+      Ft %= ForkChannel::kNumFeatureBits;
+      FeatureBits[Ft / 64] |= 1ULL << (Ft % 64);
+    }
+  }
+
+  // Whether the job found features that are not known yet.
+  bool HasNewFeatures(const ForkChannel &Channel) const {
+    if (!Channel.NumNewUnits.load(std::memory_order_acquire))
+      return false;
+    for (size_t i = 0; i < FeatureBits.size(); i++)
+      if (Channel.Features[i].load(std::memory_order_relaxed) &
+          ~FeatureBits[i])
+        return true;
+    return false;
+  }
+
   size_t secondsSinceProcessStartUp() const {
     return std::chrono::duration_cast<std::chrono::seconds>(
                std::chrono::system_clock::now() - ProcessStartTime)
@@ -119,6 +164,7 @@ struct GlobalEnv {
     Cmd.removeFlag("fork");
     Cmd.removeFlag("runs");
     Cmd.removeFlag("collect_data_flow");
+    Cmd.removeFlag("corpus_store");
     for (auto &C : CorpusDirs) // Remove all corpora from the args.
       Cmd.removeArgument(C);
     Cmd.addFlag("reload", "0");  // working in an isolated dir, no reload.
@@ -154,8 +200,14 @@ struct GlobalEnv {
     Job->CorpusDir = DirPlusFile(TempDir, "C" + std::to_string(JobId));
     Job->FeaturesDir = DirPlusFile(TempDir, "F" + std::to_string(JobId));
     Job->CFPath = DirPlusFile(TempDir, std::to_string(JobId) + ".merge");
+    Job->ChannelPath = DirPlusFile(TempDir, std::to_string(JobId) + ".channel");
+    Job->Channel = MapForkChannel(Job->ChannelPath);
     Job->JobId = JobId;
 
+    // Without a channel, fall back to the log and the feature files.
+    if (Job->Channel)
+      Cmd.addFlag("fork_channel", Job->ChannelPath);
+
 
     Cmd.addArgument(Job->CorpusDir);
     Cmd.addFlag("features_dir", Job->FeaturesDir);
@@ -178,13 +230,17 @@ struct GlobalEnv {
   }
 
   void RunOneMergeJob(FuzzJob *Job) {
-    auto Stats = ParseFinalStatsFromLog(Job->LogPath);
+    auto Stats = Job->Channel ? ReadStatsFromChannel(*Job->Channel)
+                              : ParseFinalStatsFromLog(Job->LogPath);
     NumRuns += Stats.number_of_executed_units;
 
     Vector<SizedFile> TempFiles, MergeCandidates;
     // Read all newly created inputs and their feature sets.
-    // Choose only those inputs that have new features.
-    GetSizedFilesFromDir(Job->CorpusDir, &TempFiles);
+    // Choose only those inputs that have new features. Most jobs do not find
+    // any, which the channel tells without touching the job's files; the
+    // inputs of the other jobs are still checked against the exact set.
+    if (!Job->Channel || HasNewFeatures(*Job->Channel))
+      GetSizedFilesFromDir(Job->CorpusDir, &TempFiles);
     std::sort(TempFiles.begin(), TempFiles.end());
     for (auto &F : TempFiles) {
       auto FeatureFile = F.File;
@@ -219,7 +275,7 @@ struct GlobalEnv {
       WriteToFile(U, NewPath);
       Files.push_back(NewPath);
     }
-    Features.insert(NewFeatures.begin(), NewFeatures.end());
+    AddFeatures(NewFeatures);
     Cov.insert(NewCov.begin(), NewCov.end());
     for (auto Idx : NewCov)
       if (auto *TE = TPC.PCTableEntryByIdx(Idx))
@@ -310,9 +366,11 @@ void FuzzWithFork(Random &Rand, const FuzzingOptions &Options,
     Env.MainCorpusDir = CorpusDirs[0];
 
   auto CFPath = DirPlusFile(Env.TempDir, "merge.txt");
-  CrashResistantMerge(Env.Args, {}, SeedFiles, &Env.Files, {}, &Env.Features,
+  Set<uint32_t> SeedFeatures;
+  CrashResistantMerge(Env.Args, {}, SeedFiles, &Env.Files, {}, &SeedFeatures,
                       {}, &Env.Cov,
                       CFPath, false);
+  Env.AddFeatures(SeedFeatures);
   RemoveFile(CFPath);
   Printf("INFO: -fork=%d: %zd seed inputs, starting to fuzz in %s\n", NumJobs,
          Env.Files.size(), Env.TempDir.c_str());
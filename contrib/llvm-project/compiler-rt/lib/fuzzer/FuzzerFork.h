@@ -13,9 +13,45 @@
 #include "FuzzerOptions.h"
 #include "FuzzerRandom.h"
 
+#include <atomic>
+#include <cassert>
 #include <string>
 
 namespace fuzzer {
+
+// Memory shared between the -fork=N parent and one of its children, through a
+// file mapped in both processes. The child publishes its statistics and the
+// features of the inputs it adds to its corpus as it goes, so that the parent
+// neither scrapes the child's log nor reads back feature files to learn
+// whether a job found anything new.
+struct ForkChannel {
+  // Same as InputCorpus::kFeatureSetSize. Features are published reduced
+  // modulo this size, the way InputCorpus reduces them.
+  static const size_t kNumFeatureBits = 1 << 21;
+
+  std::atomic<uint64_t> NumberOfExecutedUnits;
+  std::atomic<uint64_t> AverageExecPerSec;
+  std::atomic<uint64_t> PeakRssMb;
+  std::atomic<uint64_t> NumNewUnits;
+  std::atomic<uint64_t> Features[kNumFeatureBits / 64];
+
+  // Feature must already be reduced modulo kNumFeatureBits.
+  void AddFeature(uint32_t Feature) {
+    assert(Feature < kNumFeatureBits);
+    if (Feature >= kNumFeatureBits)
+      return;
+    uint64_t Mask = 1ULL << (Feature % 64);
+    auto &Word = Features[Feature / 64];
+    if (!(Word.load(std::memory_order_relaxed) & Mask))
+      Word.fetch_or(Mask, std::memory_order_relaxed);
+  }
+};
+
+// Maps the channel at Path, creating it zero-filled if needed.
+// Returns nullptr if shared mappings are not available.
+ForkChannel *MapForkChannel(const std::string &Path);
+void UnmapForkChannel(ForkChannel *Channel);
+
 void FuzzWithFork(Random &Rand, const FuzzingOptions &Options,
                   const Vector<std::string> &Args,
                   const Vector<std::string> &CorpusDirs, int NumJobs);
@@ -94,6 +94,12 @@ int DuplicateFile(int Fd);
 void RemoveFile(const std::string &Path);
 void RenameFile(const std::string &OldPath, const std::string &NewPath);
 
+// Maps Size bytes at Offset of the file at Path, creating or extending it if
+// needed, so that the mapping is shared with every other process mapping the
+// same file. Offset must be a multiple of 64Kb. Returns nullptr on failure.
+void *MapSharedFile(const std::string &Path, size_t Size, uint64_t Offset = 0);
+void UnmapSharedFile(void *Addr, size_t Size);
+
 intptr_t GetHandleFromFd(int fd);
 
 void MkDir(const std::string &Path);
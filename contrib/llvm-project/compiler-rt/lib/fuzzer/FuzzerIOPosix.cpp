@@ -15,9 +15,11 @@
 #include <cstdarg>
 #include <cstdio>
 #include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
 #include <iterator>
 #include <libgen.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -124,6 +126,27 @@ void RenameFile(const std::string &OldPath, const std::string &NewPath) {
   rename(OldPath.c_str(), NewPath.c_str());
 }
 
+void *MapSharedFile(const std::string &Path, size_t Size, uint64_t Offset) {
+  int Fd = open(Path.c_str(), O_RDWR | O_CREAT, 0600);
+  if (Fd < 0)
+    return nullptr;
+  void *Addr = nullptr;
+  struct stat St;
+  if (fstat(Fd, &St) == 0 &&
+      ((uint64_t)St.st_size >= Offset + Size ||
+       ftruncate(Fd, Offset + Size) == 0)) {
+    Addr = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, Offset);
+    if (Addr == MAP_FAILED)
+      Addr = nullptr;
+  }
+  close(Fd);
+  return Addr;
+}
+
+void UnmapSharedFile(void *Addr, size_t Size) {
+  munmap(Addr, Size);
+}
+
 intptr_t GetHandleFromFd(int fd) {
   return static_cast<intptr_t>(fd);
 }
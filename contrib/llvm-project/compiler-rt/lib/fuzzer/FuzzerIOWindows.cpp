@@ -223,6 +223,32 @@ void RenameFile(const std::string &OldPath, const std::string &NewPath) {
   rename(OldPath.c_str(), NewPath.c_str());
 }
 
+void *MapSharedFile(const std::string &Path, size_t Size, uint64_t Offset) {
+  HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (File == INVALID_HANDLE_VALUE)
+    return nullptr;
+  // The file is extended to the size of the mapping if it is smaller.
+  uint64_t End = Offset + Size;
+  HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READWRITE,
+                                      static_cast<DWORD>(End >> 32),
+                                      static_cast<DWORD>(End), NULL);
+  CloseHandle(File);
+  if (!Mapping)
+    return nullptr;
+  void *Addr = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS,
+                             static_cast<DWORD>(Offset >> 32),
+                             static_cast<DWORD>(Offset), Size);
+  // The view keeps the mapping alive.
+  CloseHandle(Mapping);
+  return Addr;
+}
+
+void UnmapSharedFile(void *Addr, size_t Size) {
+  UnmapViewOfFile(Addr);
+}
+
 intptr_t GetHandleFromFd(int fd) {
   return _get_osfhandle(fd);
 }
@@ -29,6 +29,8 @@ namespace fuzzer {
 
 using namespace std::chrono;
 
+struct ForkChannel;
+
 class Fuzzer {
 public:
 
@@ -101,6 +103,7 @@ class Fuzzer {
   void PrintStats(const char *Where, const char *End = "\n", size_t Units = 0,
                   size_t Features = 0);
   void PrintStatusForNewUnit(const Unit &U, const char *Text);
+  void PublishStatsToForkChannel();
   void CheckExitOnSrcPosOrItem();
 
   static void StaticDeathCallback();
@@ -140,6 +143,11 @@ class Fuzzer {
   size_t TmpMaxMutationLen = 0;
 
   Vector<uint32_t> UniqFeatureSetTmp;
+  // Copy of the input to cross over with, when it is in the CorpusStore.
+  Unit CrossOverUnit;
+
+  // Shared with the -fork=N parent, if any.
+  ForkChannel *Channel = nullptr;
 
   // Need to know our own thread.
   static thread_local bool IsMyThread;
@@ -9,6 +9,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "FuzzerCorpus.h"
+#include "FuzzerFork.h"
 #include "FuzzerIO.h"
 #include "FuzzerInternal.h"
 #include "FuzzerMutate.h"
@@ -158,6 +159,8 @@ Fuzzer::Fuzzer(UserCallback CB, InputCorpus &Corpus, MutationDispatcher &MD,
   AllocateCurrentUnitData();
   CurrentUnitSize = 0;
   memset(BaseSha1, 0, sizeof(BaseSha1));
+  if (!Options.ForkChannel.empty())
+    Channel = MapForkChannel(Options.ForkChannel);
 }
 
 Fuzzer::~Fuzzer() {}
@@ -323,6 +326,7 @@ void Fuzzer::RssLimitCallback() {
 void Fuzzer::PrintStats(const char *Where, const char *End, size_t Units,
                         size_t Features) {
   size_t ExecPerSec = execPerSec();
+  PublishStatsToForkChannel();
   if (!Options.Verbosity)
     return;
   Printf("#%zd\t%s", TotalNumberOfRuns, Where);
@@ -353,7 +357,17 @@ void Fuzzer::PrintStats(const char *Where, const char *End, size_t Units,
   Printf("%s", End);
 }
 
+void Fuzzer::PublishStatsToForkChannel() {
+  if (!Channel)
+    return;
+  Channel->NumberOfExecutedUnits.store(TotalNumberOfRuns,
+                                       std::memory_order_relaxed);
+  Channel->AverageExecPerSec.store(execPerSec(), std::memory_order_relaxed);
+  Channel->PeakRssMb.store(GetPeakRSSMb(), std::memory_order_relaxed);
+}
+
 void Fuzzer::PrintFinalStats() {
+  PublishStatsToForkChannel();
   if (Options.PrintCoverage)
     TPC.PrintCoverage();
   if (Options.PrintCorpusStats)
@@ -494,12 +508,17 @@ bool Fuzzer::RunOne(const uint8_t *Data, size_t Size, bool MayDeleteFile,
                                     UniqFeatureSetTmp, DFT, II);
     WriteFeatureSetToFile(Options.FeaturesDir, Sha1ToString(NewII->Sha1),
                           NewII->UniqFeatureSet);
+    if (Channel) {
+      for (auto Feature : NewII->UniqFeatureSet)
+        Channel->AddFeature(Feature % ForkChannel::kNumFeatureBits);
+      Channel->NumNewUnits.fetch_add(1, std::memory_order_release);
+    }
     return true;
   }
   if (II && FoundUniqFeaturesOfII &&
       II->DataFlowTraceForFocusFunction.empty() &&
       FoundUniqFeaturesOfII == II->UniqFeatureSet.size() &&
-      II->U.size() > Size) {
+      II->Size() > Size) {
     auto OldFeaturesFile = Sha1ToString(II->Sha1);
     Corpus.Replace(II, {Data, Data + Size});
     RenameFeatureSetFile(Options.FeaturesDir, OldFeaturesFile,
@@ -664,19 +683,27 @@ void Fuzzer::MutateAndTestOne() {
   MD.StartMutationSequence();
 
   auto &II = Corpus.ChooseUnitToMutate(MD.GetRand());
-  if (Options.DoCrossOver)
-    MD.SetCrossOverWith(&Corpus.ChooseUnitToMutate(MD.GetRand()).U);
-  const auto &U = II.U;
+  if (Options.DoCrossOver) {
+    auto &CrossOverII = Corpus.ChooseUnitToMutate(MD.GetRand());
+    if (CrossOverII.StoredData) {
+      // MutationDispatcher crosses over with a Unit.
+      CrossOverUnit.assign(CrossOverII.Data(),
+                           CrossOverII.Data() + CrossOverII.Size());
+      MD.SetCrossOverWith(&CrossOverUnit);
+    } else {
+      MD.SetCrossOverWith(&CrossOverII.U);
+    }
+  }
   memcpy(BaseSha1, II.Sha1, sizeof(BaseSha1));
   assert(CurrentUnitData);
-  size_t Size = U.size();
+  size_t Size = II.Size();
   assert(Size <= MaxInputLen && "Oversized Unit");
-  memcpy(CurrentUnitData, U.data(), Size);
+  memcpy(CurrentUnitData, II.Data(), Size);
 
   assert(MaxMutationLen > 0);
 
   size_t CurrentMaxMutationLen =
-      Min(MaxMutationLen, Max(U.size(), TmpMaxMutationLen));
+      Min(MaxMutationLen, Max(Size, TmpMaxMutationLen));
   assert(CurrentMaxMutationLen > 0);
 
   for (int i = 0; i < Options.MutateDepth; i++) {
@@ -735,6 +762,33 @@ void Fuzzer::ReadAndExecuteSeedCorpora(Vector<SizedFile> &CorporaFiles) {
   size_t MaxSize = 0;
   size_t MinSize = -1;
   size_t TotalSize = 0;
+
+  // Inputs already in the corpus store are executed from it, and the files
+  // holding them in the corpus directories are not read.
+  struct StoredSeed {
+    const uint8_t *Data;
+    size_t Size;
+    bool operator<(const StoredSeed &Other) const { return Size < Other.Size; }
+  };
+  Vector<StoredSeed> StoredSeeds;
+  if (auto *Store = Corpus.GetStore()) {
+    Store->ForEachLiveEntry(
+        [&](const CorpusStore::Entry &E, const uint8_t *Data) {
+          StoredSeeds.push_back({Data, static_cast<size_t>(E.Size)});
+        });
+    CorporaFiles.erase(std::remove_if(CorporaFiles.begin(), CorporaFiles.end(),
+                                      [&](const SizedFile &SF) {
+                                        return Store->Contains(
+                                            Basename(SF.File));
+                                      }),
+                       CorporaFiles.end());
+  }
+  for (auto &Seed : StoredSeeds) {
+    MaxSize = Max(Seed.Size, MaxSize);
+    MinSize = Min(Seed.Size, MinSize);
+    TotalSize += Seed.Size;
+  }
+
   for (auto &File : CorporaFiles) {
     MaxSize = Max(File.Size, MaxSize);
     MinSize = Min(File.Size, MinSize);
@@ -748,11 +802,26 @@ void Fuzzer::ReadAndExecuteSeedCorpora(Vector<SizedFile> &CorporaFiles) {
   uint8_t dummy = 0;
   ExecuteCallback(&dummy, 0);
 
-  if (CorporaFiles.empty()) {
+  if (!StoredSeeds.empty()) {
+    Printf("INFO: corpus store: inputs: %zd\n", StoredSeeds.size());
+    if (Options.ShuffleAtStartUp)
+      std::shuffle(StoredSeeds.begin(), StoredSeeds.end(), MD.GetRand());
+    if (Options.PreferSmall)
+      std::stable_sort(StoredSeeds.begin(), StoredSeeds.end());
+    for (auto &Seed : StoredSeeds) {
+      size_t Size = Min(Seed.Size, MaxInputLen);
+      RunOne(Seed.Data, Size);
+      CheckExitOnSrcPosOrItem();
+      TryDetectingAMemoryLeak(Seed.Data, Size,
+                              /*DuringInitialCorpusExecution*/ true);
+    }
+  }
+
+  if (CorporaFiles.empty() && StoredSeeds.empty()) {
     Printf("INFO: A corpus is not provided, starting from an empty corpus\n");
     Unit U({'\n'}); // Valid ASCII input.
     RunOne(U.data(), U.size());
-  } else {
+  } else if (!CorporaFiles.empty()) {
     Printf("INFO: seed corpus: files: %zd min: %zdb max: %zdb total: %zdb"
            " rss: %zdMb\n",
            CorporaFiles.size(), MinSize, MaxSize, TotalSize, GetPeakRSSMb());
@@ -775,6 +844,9 @@ void Fuzzer::ReadAndExecuteSeedCorpora(Vector<SizedFile> &CorporaFiles) {
     }
   }
 
+  if (auto *Store = Corpus.GetStore())
+    Store->RemoveUnused();
+
   PrintStats("INITED");
   if (!Options.FocusFunction.empty()) {
     Printf("INFO: %zd/%zd inputs touch the focus function\n",
@@ -15,17 +15,122 @@
 #include "FuzzerTracePC.h"
 #include "FuzzerUtil.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iterator>
+#include <memory>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_set>
 
 namespace fuzzer {
 
-bool Merger::Parse(const std::string &Str, bool ParseCoverage) {
-  std::istringstream SS(Str);
-  return Parse(SS, ParseCoverage);
+// A set of 32-bit features stored as a bitset. The bits are allocated in
+// pages on first use, so that sparse feature spaces remain cheap while lookups
+// and insertions stay O(1).
+class FeatureBitSet {
+ public:
+  FeatureBitSet() : Pages(kNumPages) {}
+
+  bool Contains(uint32_t Feature) const {
+    const uint64_t *Page = Pages[Feature >> kPageBits].get();
+    return Page && (Page[(Feature & kPageMask) / 64] >> (Feature % 64)) & 1;
+  }
+
+  // Returns true if Feature was not in the set.
+  bool Insert(uint32_t Feature) {
+    auto &Page = Pages[Feature >> kPageBits];
+    if (!Page)
+      Page.reset(new uint64_t[kPageWords]());
+    uint64_t &Word = Page[(Feature & kPageMask) / 64];
+    uint64_t Mask = 1ULL << (Feature % 64);
+    if (Word & Mask)
+      return false;
+    Word |= Mask;
+    return true;
+  }
+
+ private:
+  static const size_t kPageBits = 16;
+  static const size_t kPageMask = (1 << kPageBits) - 1;
+  static const size_t kPageWords = (1 << kPageBits) / 64;
+  static const size_t kNumPages = 1 << (32 - kPageBits);
+  Vector<std::unique_ptr<uint64_t[]>> Pages;
+};
+
+// Calls F(i) for every i in [Begin, End), splitting the range between threads
+// when it is large enough to be worth it. F must not modify shared state.
+template <class Callback>
+static void ParallelFor(size_t Begin, size_t End, Callback F) {
+  const size_t kMinItemsPerThread = 1 << 14;
+  size_t NumItems = End > Begin ? End - Begin : 0;
+  size_t NumThreads =
+      Min<size_t>(NumberOfCpuCores(), NumItems / kMinItemsPerThread);
+  if (NumThreads <= 1) {
+    for (size_t i = Begin; i < End; i++)
+      F(i);
+    return;
+  }
+  size_t ItemsPerThread = (NumItems + NumThreads - 1) / NumThreads;
+  Vector<std::thread> Threads;
+  for (size_t T = 0; T < NumThreads; T++) {
+    size_t ChunkBegin = Begin + T * ItemsPerThread;
+    size_t ChunkEnd = Min(End, ChunkBegin + ItemsPerThread);
+    Threads.push_back(std::thread([=, &F]() {
+      for (size_t i = ChunkBegin; i < ChunkEnd; i++)
+        F(i);
+    }));
+  }
+  for (auto &T : Threads)
+    T.join();
+}
+
+// A line of the control file, as a [Begin, End) range of characters.
+struct ControlFileLine {
+  const char *Begin, *End;
+};
+
+static bool IsSpace(char C) {
+  return C == ' ' || C == '\t' || C == '\r' || C == '\v' || C == '\f';
+}
+
+// Reads the next whitespace separated token of *L into Token, consuming it.
+static bool ParseToken(ControlFileLine *L, std::string *Token) {
+  while (L->Begin != L->End && IsSpace(*L->Begin))
+    L->Begin++;
+  const char *Start = L->Begin;
+  while (L->Begin != L->End && !IsSpace(*L->Begin))
+    L->Begin++;
+  Token->assign(Start, L->Begin);
+  return !Token->empty();
+}
+
+// Reads the next unsigned decimal number of *L into N, consuming it. Mirrors
+// the behaviour of istream's operator>>, which the control file format was
+// defined with: a failed read sets N to 0.
+static bool ParseNumber(ControlFileLine *L, size_t *N) {
+  while (L->Begin != L->End && IsSpace(*L->Begin))
+    L->Begin++;
+  *N = 0;
+  if (L->Begin == L->End || !isdigit(*L->Begin))
+    return false;
+  while (L->Begin != L->End && isdigit(*L->Begin))
+    *N = *N * 10 + (*L->Begin++ - '0');
+  return true;
+}
+
+static void ParseNumbers(ControlFileLine L, Vector<uint32_t> *Numbers) {
+  size_t N;
+  while (ParseNumber(&L, &N))
+    Numbers->push_back(N);
+}
+
+bool Merger::Parse(std::istream &IS, bool ParseCoverage) {
+  std::string Str((std::istreambuf_iterator<char>(IS)),
+                  std::istreambuf_iterator<char>());
+  return Parse(Str, ParseCoverage);
 }
 
 void Merger::ParseOrExit(std::istream &IS, bool ParseCoverage) {
@@ -49,47 +154,62 @@ void Merger::ParseOrExit(std::istream &IS, bool ParseCoverage) {
 // STARTED 2 567
 // FT 2 8 9
 // COV 2 11 12
-bool Merger::Parse(std::istream &IS, bool ParseCoverage) {
+//
+// The structure of the file is validated in a sequential pass which only looks
+// at the marker and file ID of each line. The feature and coverage lists, which
+// make up the bulk of the file, are then parsed in parallel.
+bool Merger::Parse(const std::string &Str, bool ParseCoverage) {
   LastFailure.clear();
-  std::string Line;
+  const char *Pos = Str.data();
+  const char *End = Pos + Str.size();
+  // Same semantics as getline(): a trailing newline does not start a new line.
+  auto NextLine = [&](ControlFileLine *L) {
+    if (Pos == End)
+      return false;
+    const char *EOL = static_cast<const char *>(memchr(Pos, '\n', End - Pos));
+    L->Begin = Pos;
+    L->End = EOL ? EOL : End;
+    Pos = EOL ? EOL + 1 : End;
+    return true;
+  };
+  ControlFileLine Line;
 
   // Parse NumFiles.
-  if (!std::getline(IS, Line, '\n')) return false;
-  std::istringstream L1(Line);
+  if (!NextLine(&Line)) return false;
   size_t NumFiles = 0;
-  L1 >> NumFiles;
+  ParseNumber(&Line, &NumFiles);
   if (NumFiles == 0 || NumFiles > 10000000) return false;
 
   // Parse NumFilesInFirstCorpus.
-  if (!std::getline(IS, Line, '\n')) return false;
-  std::istringstream L2(Line);
-  NumFilesInFirstCorpus = NumFiles + 1;
-  L2 >> NumFilesInFirstCorpus;
+  if (!NextLine(&Line)) return false;
+  if (!ParseNumber(&Line, &NumFilesInFirstCorpus))
+    NumFilesInFirstCorpus = NumFiles + 1;
   if (NumFilesInFirstCorpus > NumFiles) return false;
 
   // Parse file names.
   Files.resize(NumFiles);
-  for (size_t i = 0; i < NumFiles; i++)
-    if (!std::getline(IS, Files[i].Name, '\n'))
+  for (size_t i = 0; i < NumFiles; i++) {
+    if (!NextLine(&Line))
       return false;
+    Files[i].Name.assign(Line.Begin, Line.End);
+  }
 
   // Parse STARTED, FT, and COV lines.
   size_t ExpectedStartMarker = 0;
   const size_t kInvalidStartMarker = -1;
   size_t LastSeenStartMarker = kInvalidStartMarker;
-  Vector<uint32_t> TmpFeatures;
-  Set<uint32_t> PCs;
-  while (std::getline(IS, Line, '\n')) {
-    std::istringstream ISS1(Line);
-    std::string Marker;
+  // FT and COV lines, with their file ID and marker already consumed.
+  Vector<std::pair<size_t, ControlFileLine>> FTLines, CovLines;
+  std::string Marker;
+  while (NextLine(&Line)) {
     size_t N;
-    ISS1 >> Marker;
-    ISS1 >> N;
+    ParseToken(&Line, &Marker);
+    ParseNumber(&Line, &N);
     if (Marker == "STARTED") {
       // STARTED FILE_ID FILE_SIZE
       if (ExpectedStartMarker != N)
         return false;
-      ISS1 >> Files[ExpectedStartMarker].Size;
+      ParseNumber(&Line, &Files[ExpectedStartMarker].Size);
       LastSeenStartMarker = ExpectedStartMarker;
       assert(ExpectedStartMarker < Files.size());
       ExpectedStartMarker++;
@@ -99,19 +219,14 @@ bool Merger::Parse(std::istream &IS, bool ParseCoverage) {
       if (CurrentFileIdx != LastSeenStartMarker)
         return false;
       LastSeenStartMarker = kInvalidStartMarker;
-      if (ParseCoverage) {
-        TmpFeatures.clear();  // use a vector from outer scope to avoid resizes.
-        while (ISS1 >> N)
-          TmpFeatures.push_back(N);
-        std::sort(TmpFeatures.begin(), TmpFeatures.end());
-        Files[CurrentFileIdx].Features = TmpFeatures;
-      }
+      if (ParseCoverage)
+        FTLines.push_back({CurrentFileIdx, Line});
     } else if (Marker == "COV") {
       size_t CurrentFileIdx = N;
+      if (CurrentFileIdx >= Files.size())
+        return false;
       if (ParseCoverage)
-        while (ISS1 >> N)
-          if (PCs.insert(N).second)
-            Files[CurrentFileIdx].Cov.push_back(N);
+        CovLines.push_back({CurrentFileIdx, Line});
     } else {
       return false;
     }
@@ -120,6 +235,29 @@ bool Merger::Parse(std::istream &IS, bool ParseCoverage) {
     LastFailure = Files[LastSeenStartMarker].Name;
 
   FirstNotProcessedFile = ExpectedStartMarker;
+  if (!ParseCoverage)
+    return true;
+
+  // There is at most one FT line per file, so these can be filled in place.
+  ParallelFor(0, FTLines.size(), [&](size_t i) {
+    auto &Features = Files[FTLines[i].first].Features;
+    Features.clear();
+    ParseNumbers(FTLines[i].second, &Features);
+    std::sort(Features.begin(), Features.end());
+  });
+  // Each PC is attributed to the first file covering it, in file order.
+  Vector<Vector<uint32_t>> CovNumbers(CovLines.size());
+  ParallelFor(0, CovLines.size(), [&](size_t i) {
+    ParseNumbers(CovLines[i].second, &CovNumbers[i]);
+  });
+  FeatureBitSet PCs;
+  for (size_t i = 0; i < CovLines.size(); i++) {
+    auto &Cov = Files[CovLines[i].first].Cov;
+    for (auto PC : CovNumbers[i])
+      if (PCs.Insert(PC))
+        Cov.push_back(PC);
+    Vector<uint32_t>().swap(CovNumbers[i]);
+  }
   return true;
 }
 
@@ -138,21 +276,24 @@ size_t Merger::Merge(const Set<uint32_t> &InitialFeatures,
                      Vector<std::string> *NewFiles) {
   NewFiles->clear();
   assert(NumFilesInFirstCorpus <= Files.size());
-  Set<uint32_t> AllFeatures = InitialFeatures;
+  FeatureBitSet AllFeatures;
+  for (auto Fe : InitialFeatures)
+    AllFeatures.Insert(Fe);
 
   // What features are in the initial corpus?
-  for (size_t i = 0; i < NumFilesInFirstCorpus; i++) {
-    auto &Cur = Files[i].Features;
-    AllFeatures.insert(Cur.begin(), Cur.end());
-  }
+  for (size_t i = 0; i < NumFilesInFirstCorpus; i++)
+    for (auto Fe : Files[i].Features)
+      AllFeatures.Insert(Fe);
+
   // Remove all features that we already know from all other inputs.
-  for (size_t i = NumFilesInFirstCorpus; i < Files.size(); i++) {
+  ParallelFor(NumFilesInFirstCorpus, Files.size(), [&](size_t i) {
     auto &Cur = Files[i].Features;
-    Vector<uint32_t> Tmp;
-    std::set_difference(Cur.begin(), Cur.end(), AllFeatures.begin(),
-                        AllFeatures.end(), std::inserter(Tmp, Tmp.begin()));
-    Cur.swap(Tmp);
-  }
+    Cur.erase(std::remove_if(Cur.begin(), Cur.end(),
+                             [&](uint32_t Fe) {
+                               return AllFeatures.Contains(Fe);
+                             }),
+              Cur.end());
+  });
 
   // Sort. Give preference to
   //   * smaller files
@@ -172,7 +313,7 @@ size_t Merger::Merge(const Set<uint32_t> &InitialFeatures,
     //       Files[i].Size, Cur.size());
     bool FoundNewFeatures = false;
     for (auto Fe: Cur) {
-      if (AllFeatures.insert(Fe).second) {
+      if (AllFeatures.Insert(Fe)) {
         FoundNewFeatures = true;
         NewFeatures->insert(Fe);
       }
@@ -363,6 +504,7 @@ void CrashResistantMerge(const Vector<std::string> &Args,
   BaseCmd.removeFlag("merge");
   BaseCmd.removeFlag("fork");
   BaseCmd.removeFlag("collect_data_flow");
+  BaseCmd.removeFlag("corpus_store");
   for (size_t Attempt = 1; Attempt <= NumAttempts; Attempt++) {
     Fuzzer::MaybeExitGracefully();
     VPrintf(V, "MERGE-OUTER: attempt %zd\n", Attempt);
@@ -31,6 +31,25 @@ namespace fuzzer {
 
 TracePC TPC;
 
+const uint8_t CounterToFeatureTable[256] = {
+    0, 0, 1, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+};
+
 size_t TracePC::GetTotalPCCoverage() {
   return ObservedPCs.size();
 }
@@ -56,11 +75,11 @@ void TracePC::HandleInline8bitCountersInit(uint8_t *Start, uint8_t *Stop) {
   assert(M.Regions);
   size_t R = 0;
   if (NeedFirst)
-    M.Regions[R++] = {Start, std::min(Stop, AlignedStart), true, false};
+    M.Regions[R++] = {Start, std::min(Stop, AlignedStart), true, false, true};
   for (uint8_t *P = AlignedStart; P < AlignedStop; P += PageSize())
-    M.Regions[R++] = {P, P + PageSize(), true, true};
+    M.Regions[R++] = {P, P + PageSize(), true, true, true};
   if (NeedLast)
-    M.Regions[R++] = {AlignedStop, Stop, true, false};
+    M.Regions[R++] = {AlignedStop, Stop, true, false, true};
   assert(R == M.NumRegions);
   assert(M.Size() == (size_t)(Stop - Start));
   assert(M.Stop() == Stop);
@@ -380,10 +399,40 @@ static size_t InternalStrnlen2(const char *S1, const char *S2) {
   return Len;
 }
 
+ATTRIBUTE_NO_SANITIZE_ALL
+static bool HasNonZeroByte(const uint8_t *Begin, const uint8_t *End) {
+  typedef uintptr_t LargeType;
+  const size_t Step = sizeof(LargeType);
+  const size_t WordsPerBlock = 8;
+  auto P = Begin;
+  for (; reinterpret_cast<uintptr_t>(P) & (Step - 1) && P < End; P++)
+    if (*P)
+      return true;
+  for (; End - P >= static_cast<ptrdiff_t>(WordsPerBlock * Step);
+       P += WordsPerBlock * Step) {
+    const LargeType *Words = reinterpret_cast<const LargeType *>(P);
+    LargeType Any = 0;
+    for (size_t W = 0; W < WordsPerBlock; W++)
+      Any |= Words[W];
+    if (Any)
+      return true;
+  }
+  for (; P < End; P++)
+    if (*P)
+      return true;
+  return false;
+}
+
 void TracePC::ClearInlineCounters() {
-  IterateCounterRegions([](const Module::Region &R){
-    if (R.Enabled)
+  // Regions that had counters set when CollectFeatures() last scanned them are
+  // cleared right away. The others are most likely still clear, but counters
+  // may have been bumped since the scan, e.g. by a custom mutator or by
+  // another thread, so they are checked first. Reading a clear region is
+  // cheaper than writing it, and most of a large map stays clear.
+  IterateCounterRegions([](Module::Region &R) {
+    if (R.Enabled && (R.Dirty || HasNonZeroByte(R.Start, R.Stop)))
       memset(R.Start, 0, R.Stop - R.Start);
+    R.Dirty = false;
   });
 }
 
@@ -79,7 +79,8 @@ class TracePC {
   void SetPrintNewPCs(bool P) { DoPrintNewPCs = P; }
   void SetPrintNewFuncs(size_t P) { NumPrintNewFuncs = P; }
   void UpdateObservedPCs();
-  template <class Callback> void CollectFeatures(Callback CB) const;
+  // Not const: it records in each counter region whether the run touched it.
+  template <class Callback> void CollectFeatures(Callback CB);
 
   void ResetMaps() {
     ValueProfileMap.Reset();
@@ -142,6 +143,9 @@ class TracePC {
       uint8_t *Start, *Stop;
       bool Enabled;
       bool OneFullPage;
+      // Whether the region had non-zero counters when last scanned. A clean
+      // region may still have been written to since then.
+      bool Dirty;
     };
     Region *Regions;
     size_t NumRegions;
@@ -186,18 +190,40 @@ size_t ForEachNonZeroByte(const uint8_t *Begin, const uint8_t *End,
   typedef uintptr_t LargeType;
   const size_t Step = sizeof(LargeType) / sizeof(uint8_t);
   const size_t StepMask = Step - 1;
+  // Number of LargeType words checked at once for being all zeros.
+  const size_t WordsPerBlock = 8;
   auto P = Begin;
   // Iterate by 1 byte until either the alignment boundary or the end.
   for (; reinterpret_cast<uintptr_t>(P) & StepMask && P < End; P++)
     if (uint8_t V = *P)
       Handle8bitCounter(FirstFeature, P - Begin, V);
 
+  auto HandleBundle = [&](const uint8_t *BundleP, LargeType Bundle) {
+    for (size_t I = 0; Bundle; I++, Bundle >>= 8)
+      if (uint8_t V = Bundle & 0xff)
+        Handle8bitCounter(FirstFeature, BundleP - Begin + I, V);
+  };
+
+  // Iterate by blocks of WordsPerBlock * Step bytes. Most of the counters are
+  // zero in a given run, and OR-ing the words of a block is vectorized by the
+  // compiler, so untouched parts of large maps are skipped at memory speed.
+  for (; End - P >= static_cast<ptrdiff_t>(WordsPerBlock * Step);
+       P += WordsPerBlock * Step) {
+    const LargeType *Words = reinterpret_cast<const LargeType *>(P);
+    LargeType Any = 0;
+    for (size_t W = 0; W < WordsPerBlock; W++)
+      Any |= Words[W];
+    if (!Any)
+      continue;
+    for (size_t W = 0; W < WordsPerBlock; W++)
+      if (LargeType Bundle = Words[W])
+        HandleBundle(P + W * Step, Bundle);
+  }
+
   // Iterate by Step bytes at a time.
-  for (; P < End; P += Step)
+  for (; End - P >= static_cast<ptrdiff_t>(Step); P += Step)
     if (LargeType Bundle = *reinterpret_cast<const LargeType *>(P))
-      for (size_t I = 0; I < Step; I++, Bundle >>= 8)
-        if (uint8_t V = Bundle & 0xff)
-          Handle8bitCounter(FirstFeature, P - Begin + I, V);
+      HandleBundle(P, Bundle);
 
   // Iterate by 1 byte until the end.
   for (; P < End; P++)
@@ -232,10 +258,18 @@ unsigned CounterToFeature(T Counter) {
     return Bit;
 }
 
+// CounterToFeature() for every 8-bit counter value, see above.
+extern const uint8_t CounterToFeatureTable[256];
+
+inline unsigned CounterToFeature(uint8_t Counter) {
+  assert(Counter);
+  return CounterToFeatureTable[Counter];
+}
+
 template <class Callback>  // void Callback(size_t Feature)
 ATTRIBUTE_NO_SANITIZE_ADDRESS
 ATTRIBUTE_NOINLINE
-void TracePC::CollectFeatures(Callback HandleFeature) const {
+void TracePC::CollectFeatures(Callback HandleFeature) {
   auto Handle8bitCounter = [&](size_t FirstFeature,
                                size_t Idx, uint8_t Counter) {
     if (UseCounters)
@@ -246,15 +280,25 @@ void TracePC::CollectFeatures(Callback HandleFeature) const {
 
   size_t FirstFeature = 0;
 
+  // Remember which regions were touched by the run, so that the next
+  // ClearInlineCounters() clears them without checking them first.
+  bool Touched;
+  auto HandleAndTrack8bitCounter = [&](size_t FirstFeature, size_t Idx,
+                                       uint8_t Counter) {
+    Touched = true;
+    Handle8bitCounter(FirstFeature, Idx, Counter);
+  };
+
   for (size_t i = 0; i < NumModules; i++) {
     for (size_t r = 0; r < Modules[i].NumRegions; r++) {
-      if (!Modules[i].Regions[r].Enabled) continue;
-      FirstFeature += 8 * ForEachNonZeroByte(Modules[i].Regions[r].Start,
-                                             Modules[i].Regions[r].Stop,
-                                             FirstFeature, Handle8bitCounter);
+      auto &R = Modules[i].Regions[r];
+      if (!R.Enabled) continue;
+      Touched = false;
+      FirstFeature += 8 * ForEachNonZeroByte(R.Start, R.Stop, FirstFeature,
+                                             HandleAndTrack8bitCounter);
+      R.Dirty = Touched;
     }
   }
-
   FirstFeature +=
       8 * ForEachNonZeroByte(ExtraCountersBegin(), ExtraCountersEnd(),
                              FirstFeature, Handle8bitCounter);
@@ -22,6 +22,7 @@
 #include <io.h>
 #include <process.h>
 #else
+#include <fcntl.h>
 #include <sys/file.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -161,6 +162,192 @@ static void initFileWriter(ProfDataWriter *This, FILE *File) {
   This->WriterCtx = File;
 }
 
+#if !defined(_WIN32)
+/* Size of the buffer of the stream writer. */
+#define STREAM_BUFFER_SIZE (1 << 20)
+/* Shortest run of zeroes left as a hole in sparse profiles. */
+#define STREAM_HOLE_SIZE 4096
+
+/* Writer bypassing stdio to write the profile in large chunks. In sparse
+ * mode (LLVM_PROFILE_SPARSE), runs of zeroes written past the end of the
+ * file, e.g. the counters of the functions that were not executed, are not
+ * written: the file is extended with ftruncate() instead, leaving a hole.
+ * The file reads exactly the same, so the runtime merging and llvm-profdata
+ * need no change, but the holes take neither disk space nor I/O. */
+typedef struct StreamWriterCtx {
+  int Fd;
+  int Sparse;
+  /* Whether the writes happen at the end of the file, so that it can be
+   * extended instead of written to. */
+  int AtEnd;
+  int Error;
+  char *Buffer;
+  size_t BufferPos;
+  /* Zeroes to write after the contents of Buffer. */
+  uint64_t PendingZeroes;
+} StreamWriterCtx;
+
+static int isZeroes(const char *Data, size_t Size) {
+  size_t I;
+  for (I = 0; I < Size; I++)
+    if (Data[I])
+      return 0;
+  return 1;
+}
+
+static void flushStreamBuffer(StreamWriterCtx *Ctx) {
+  size_t Pos = 0;
+  while (Pos < Ctx->BufferPos && !Ctx->Error) {
+    ssize_t Written = write(Ctx->Fd, Ctx->Buffer + Pos, Ctx->BufferPos - Pos);
+    if (Written < 0 && errno == EINTR)
+      continue;
+    if (Written <= 0)
+      Ctx->Error = 1;
+    else
+      Pos += Written;
+  }
+  Ctx->BufferPos = 0;
+}
+
+/* Append \p Size bytes at \p Data, or zeroes if \p Data is null. */
+static void appendToStream(StreamWriterCtx *Ctx, const char *Data,
+                           uint64_t Size) {
+  while (Size > 0 && !Ctx->Error) {
+    size_t Len = STREAM_BUFFER_SIZE - Ctx->BufferPos;
+    if (Len > Size)
+      Len = Size;
+    if (Data) {
+      memcpy(Ctx->Buffer + Ctx->BufferPos, Data, Len);
+      Data += Len;
+    } else
+      memset(Ctx->Buffer + Ctx->BufferPos, 0, Len);
+    Ctx->BufferPos += Len;
+    Size -= Len;
+    if (Ctx->BufferPos == STREAM_BUFFER_SIZE)
+      flushStreamBuffer(Ctx);
+  }
+}
+
+/* Extend the file by \p Size zeroes without writing them. */
+static void extendStream(StreamWriterCtx *Ctx, uint64_t Size) {
+  off_t End;
+  flushStreamBuffer(Ctx);
+  if (Ctx->Error)
+    return;
+  End = lseek(Ctx->Fd, 0, SEEK_END);
+  if (End < 0 || ftruncate(Ctx->Fd, End + Size) ||
+      lseek(Ctx->Fd, 0, SEEK_END) < 0)
+    Ctx->Error = 1;
+}
+
+static void flushStreamZeroes(StreamWriterCtx *Ctx) {
+  if (!Ctx->PendingZeroes)
+    return;
+  if (Ctx->Sparse && Ctx->AtEnd && Ctx->PendingZeroes >= STREAM_HOLE_SIZE)
+    extendStream(Ctx, Ctx->PendingZeroes);
+  else
+    appendToStream(Ctx, NULL, Ctx->PendingZeroes);
+  Ctx->PendingZeroes = 0;
+}
+
+static uint32_t streamWriter(ProfDataWriter *This, ProfDataIOVec *IOVecs,
+                             uint32_t NumIOVecs) {
+  StreamWriterCtx *Ctx = (StreamWriterCtx *)This->WriterCtx;
+  uint32_t I;
+  for (I = 0; I < NumIOVecs && !Ctx->Error; I++) {
+    const char *Data = (const char *)IOVecs[I].Data;
+    uint64_t Size = (uint64_t)IOVecs[I].ElmSize * IOVecs[I].NumElm;
+    if (Data && Ctx->Sparse && Ctx->AtEnd) {
+      while (Size > 0) {
+        size_t Len = Size < STREAM_HOLE_SIZE ? Size : STREAM_HOLE_SIZE;
+        if (isZeroes(Data, Len)) {
+          Ctx->PendingZeroes += Len;
+        } else {
+          flushStreamZeroes(Ctx);
+          appendToStream(Ctx, Data, Len);
+        }
+        Data += Len;
+        Size -= Len;
+      }
+    } else if (Data) {
+      flushStreamZeroes(Ctx);
+      appendToStream(Ctx, Data, Size);
+    } else if (IOVecs[I].UseZeroPadding) {
+      Ctx->PendingZeroes += Size;
+    } else {
+      /* Skip over existing data. */
+      flushStreamZeroes(Ctx);
+      flushStreamBuffer(Ctx);
+      if (Ctx->AtEnd)
+        extendStream(Ctx, Size);
+      else if (lseek(Ctx->Fd, Size, SEEK_CUR) < 0)
+        Ctx->Error = 1;
+    }
+  }
+  return Ctx->Error;
+}
+
+/* Set up \p This to write to \p File through the stream writer. Returns 0
+ * if the buffer could not be allocated. */
+static int initStreamWriter(ProfDataWriter *This, StreamWriterCtx *Ctx,
+                            FILE *File) {
+  const char *SparseStr = getenv("LLVM_PROFILE_SPARSE");
+  off_t Cur, End;
+
+  if (fflush(File))
+    return 0;
+  memset(Ctx, 0, sizeof(*Ctx));
+  Ctx->Fd = fileno(File);
+  Ctx->Sparse = SparseStr && SparseStr[0] && SparseStr[0] != '0';
+  if (Ctx->Sparse) {
+    Cur = lseek(Ctx->Fd, 0, SEEK_CUR);
+    End = lseek(Ctx->Fd, 0, SEEK_END);
+    if (Cur >= 0 && End >= 0) {
+      Ctx->AtEnd =
+          (fcntl(Ctx->Fd, F_GETFL) & O_APPEND) || Cur == End;
+      if (lseek(Ctx->Fd, Cur, SEEK_SET) < 0)
+        return 0;
+    }
+  }
+  Ctx->Buffer = (char *)malloc(STREAM_BUFFER_SIZE);
+  if (!Ctx->Buffer)
+    return 0;
+  This->Write = streamWriter;
+  This->WriterCtx = Ctx;
+  return 1;
+}
+
+/* Write out what is left in the stream writer and release it. Returns
+ * nonzero if any write failed. */
+static int finishStreamWriter(StreamWriterCtx *Ctx) {
+  flushStreamZeroes(Ctx);
+  flushStreamBuffer(Ctx);
+  free(Ctx->Buffer);
+  return Ctx->Error;
+}
+#endif
+
+/* Write the profile data to \p File. The stream writer is only used when
+ * \p OwnsFile is set, as it leaves the stdio position of \p File behind. */
+static int writeDataToFile(FILE *File, int OwnsFile, int SkipNameDataWrite) {
+  ProfDataWriter fileWriter;
+  int RetVal;
+#if !defined(_WIN32)
+  StreamWriterCtx StreamCtx;
+  if (OwnsFile && initStreamWriter(&fileWriter, &StreamCtx, File)) {
+    RetVal = lprofWriteData(&fileWriter, lprofGetVPDataReader(),
+                            SkipNameDataWrite);
+    if (finishStreamWriter(&StreamCtx))
+      RetVal = -1;
+    return RetVal;
+  }
+#endif
+  initFileWriter(&fileWriter, File);
+  RetVal =
+      lprofWriteData(&fileWriter, lprofGetVPDataReader(), SkipNameDataWrite);
+  return RetVal;
+}
+
 COMPILER_RT_VISIBILITY ProfBufferIO *
 lprofCreateBufferIOInternal(void *File, uint32_t BufferSz) {
   FreeHook = &free;
@@ -324,6 +511,120 @@ static FILE *getFileObject(const char *OutputName) {
   return fopen(OutputName, "ab");
 }
 
+/* With LLVM_PROFILE_ATOMIC_MERGE set, processes sharing a %m profile add
+ * their counters to the profile in place instead of merging it under the
+ * exclusive file lock. */
+static int isAtomicMergeRequested() {
+  const char *AtomicMergeStr = getenv("LLVM_PROFILE_ATOMIC_MERGE");
+  return lprofCurFilename.MergePoolSize && AtomicMergeStr &&
+         AtomicMergeStr[0] && AtomicMergeStr[0] != '0';
+}
+
+#if !defined(_WIN32) && COMPILER_RT_HAS_ATOMICS == 1
+/* Write the value profile data of the process to a raw profile of its own,
+ * named after \p ProfileFileName with the pid appended. Its counters are
+ * zero, as they have already been added to the shared profile, so merging
+ * it with llvm-profdata along with the shared profile loses nothing. */
+static int writeValueProfileLog(const char *ProfileFileName) {
+  const __llvm_profile_data *DataBegin = __llvm_profile_begin_data();
+  const __llvm_profile_data *DataEnd = __llvm_profile_end_data();
+  const __llvm_profile_data *DI;
+  size_t Length = strlen(ProfileFileName) + MAX_PID_SIZE + 4;
+  char *LogFileName = (char *)COMPILER_RT_ALLOCA(Length);
+  FILE *LogFile;
+  int RetVal;
+
+  for (DI = DataBegin; DI < DataEnd; ++DI)
+    if (DI->Values)
+      break;
+  if (DI == DataEnd)
+    return 0;
+
+  snprintf(LogFileName, Length, "%s.%ld.vp", ProfileFileName, (long)getpid());
+  LogFile = fopen(LogFileName, "wb");
+  if (!LogFile) {
+    PROF_ERR("Failed to open value profile log \"%s\": %s\n", LogFileName,
+             strerror(errno));
+    return -1;
+  }
+  setupIOBuffer();
+  RetVal = writeDataToFile(LogFile, 1, 0);
+  fclose(LogFile);
+  return RetVal;
+}
+
+/* Add the counters of the process to those of the profile \p ProfileFileName
+ * with atomic adds on a shared mapping of the file. Only a shared lock is
+ * taken, so that processes exiting at the same time do not wait on each other,
+ * while the processes rewriting the whole profile still exclude them.
+ *
+ * Returns 1 if the profile does not exist yet or is not compatible, in which
+ * case it must be written the regular way. Otherwise, the counters of the
+ * process are reset once added, so that a later dump only adds what was
+ * counted since, and 0 is returned unless the value profile log could not be
+ * written. */
+static int addCountersToProfile(const char *ProfileFileName) {
+  uint64_t *CountersBegin = __llvm_profile_begin_counters();
+  uint64_t *CountersEnd = __llvm_profile_end_counters();
+  const __llvm_profile_header *Header;
+  uint64_t *ProfileCounters;
+  uint64_t ProfileFileSize, I;
+  char *ProfileBuffer;
+  off_t FileEnd;
+  int Fd, RetVal;
+
+  Fd = open(ProfileFileName, O_RDWR);
+  if (Fd < 0)
+    return 1;
+  if (lprofLockFdShared(Fd) != 0) {
+    close(Fd);
+    return 1;
+  }
+
+  FileEnd = lseek(Fd, 0, SEEK_END);
+  if (FileEnd < (off_t)sizeof(__llvm_profile_header)) {
+    lprofUnlockFd(Fd);
+    close(Fd);
+    return 1;
+  }
+  ProfileFileSize = FileEnd;
+
+  ProfileBuffer = mmap(NULL, ProfileFileSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_FILE, Fd, 0);
+  if (ProfileBuffer == MAP_FAILED) {
+    lprofUnlockFd(Fd);
+    close(Fd);
+    return 1;
+  }
+  if (__llvm_profile_check_compatibility(ProfileBuffer, ProfileFileSize)) {
+    (void)munmap(ProfileBuffer, ProfileFileSize);
+    lprofUnlockFd(Fd);
+    close(Fd);
+    return 1;
+  }
+
+  Header = (const __llvm_profile_header *)ProfileBuffer;
+  ProfileCounters =
+      (uint64_t *)(ProfileBuffer + sizeof(__llvm_profile_header) +
+                   Header->DataSize * sizeof(__llvm_profile_data) +
+                   Header->PaddingBytesBeforeCounters);
+  for (I = 0; I < (uint64_t)(CountersEnd - CountersBegin); I++)
+    if (CountersBegin[I])
+      __sync_fetch_and_add(&ProfileCounters[I], CountersBegin[I]);
+
+  (void)munmap(ProfileBuffer, ProfileFileSize);
+  lprofUnlockFd(Fd);
+  close(Fd);
+
+  memset(CountersBegin, 0, sizeof(uint64_t) * (CountersEnd - CountersBegin));
+  RetVal = writeValueProfileLog(ProfileFileName);
+  __llvm_profile_reset_counters();
+  return RetVal;
+}
+#else
+static int addCountersToProfile(const char *ProfileFileName) { return 1; }
+#endif
+
 /* Write profile data to file \c OutputName.  */
 static int writeFile(const char *OutputName) {
   int RetVal;
@@ -331,6 +632,12 @@ static int writeFile(const char *OutputName) {
 
   int MergeDone = 0;
   VPMergeHook = &lprofMergeValueProfData;
+  FreeHook = &free;
+  if (isAtomicMergeRequested() && !getProfileFile()) {
+    RetVal = addCountersToProfile(OutputName);
+    if (RetVal != 1)
+      return RetVal;
+  }
   if (doMerging())
     OutputFile = openFileForMerging(OutputName, &MergeDone);
   else
@@ -339,11 +646,9 @@ static int writeFile(const char *OutputName) {
   if (!OutputFile)
     return -1;
 
-  FreeHook = &free;
   setupIOBuffer();
-  ProfDataWriter fileWriter;
-  initFileWriter(&fileWriter, OutputFile);
-  RetVal = lprofWriteData(&fileWriter, lprofGetVPDataReader(), MergeDone);
+  RetVal =
+      writeDataToFile(OutputFile, OutputFile != getProfileFile(), MergeDone);
 
   if (OutputFile == getProfileFile()) {
     fflush(OutputFile);
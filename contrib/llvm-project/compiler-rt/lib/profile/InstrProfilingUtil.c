@@ -172,6 +172,31 @@ COMPILER_RT_VISIBILITY int lprofUnlockFd(int fd) {
 #endif
 }
 
+COMPILER_RT_VISIBILITY int lprofLockFdShared(int fd) {
+#ifdef COMPILER_RT_HAS_FCNTL_LCK
+  struct flock s_flock;
+
+  s_flock.l_whence = SEEK_SET;
+  s_flock.l_start = 0;
+  s_flock.l_len = 0; /* Until EOF.  */
+  s_flock.l_pid = getpid();
+  s_flock.l_type = F_RDLCK;
+
+  while (fcntl(fd, F_SETLKW, &s_flock) == -1) {
+    if (errno != EINTR) {
+      if (errno == ENOLCK) {
+        return -1;
+      }
+      break;
+    }
+  }
+  return 0;
+#else
+  flock(fd, LOCK_SH);
+  return 0;
+#endif
+}
+
 COMPILER_RT_VISIBILITY int lprofLockFileHandle(FILE *F) {
   int fd;
 #if defined(_WIN32)
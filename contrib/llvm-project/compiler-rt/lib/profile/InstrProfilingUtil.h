@@ -23,6 +23,9 @@ unsigned __llvm_profile_get_dir_mode(void);
 
 int lprofLockFd(int fd);
 int lprofUnlockFd(int fd);
+/*! Take a shared lock on \c fd, which only excludes the holders of the
+ * exclusive lock taken by lprofLockFd. */
+int lprofLockFdShared(int fd);
 int lprofLockFileHandle(FILE *F);
 int lprofUnlockFileHandle(FILE *F);
 
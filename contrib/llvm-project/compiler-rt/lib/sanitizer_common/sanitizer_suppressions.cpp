@@ -28,6 +28,7 @@ SuppressionContext::SuppressionContext(const char *suppression_types[],
       can_parse_(true) {
   CHECK_LE(suppression_types_num_, kMaxSuppressionTypes);
   internal_memset(has_suppression_type_, 0, suppression_types_num_);
+  atomic_store_relaxed(&pc_cache_, 0);
 }
 
 #if !SANITIZER_FUCHSIA
@@ -88,14 +89,88 @@ void SuppressionContext::ParseFromFile(const char *filename) {
   Parse(file_contents);
 }
 
+// Compiles a template into a program with the same semantics as
+// TemplateMatch(). The program is an optional leading '^', followed by a
+// sequence of '*', '$' and 'L' operations, the latter being followed by the
+// NUL-terminated literal to search for. A NUL operation ends the program.
+static char *CompileTemplate(const char *templ) {
+  uptr len = internal_strlen(templ);
+  // Worst case, every character is a literal of its own.
+  char *program = (char *)InternalAlloc(2 * len + 2);
+  char *out = program;
+  if (templ[0] == '^')
+    *out++ = *templ++;
+  while (templ[0]) {
+    if (templ[0] == '*' || templ[0] == '$') {
+      *out++ = *templ++;
+      continue;
+    }
+    *out++ = 'L';
+    while (templ[0] && templ[0] != '*' && templ[0] != '$')
+      *out++ = *templ++;
+    *out++ = 0;
+  }
+  *out = 0;
+  return program;
+}
+
+static bool ProgramMatch(const char *program, const char *str) {
+  if ((!str) || str[0] == 0)
+    return false;
+  bool start = false;
+  if (program[0] == '^') {
+    start = true;
+    program++;
+  }
+  bool asterisk = false;
+  while (program[0]) {
+    char op = *program++;
+    if (op == '*') {
+      start = false;
+      asterisk = true;
+      continue;
+    }
+    if (op == '$')
+      return str[0] == 0 || asterisk;
+    const char *literal = program;
+    uptr len = internal_strlen(literal);
+    program += len + 1;
+    if (str[0] == 0)
+      return false;
+    const char *spos = internal_strstr(str, literal);
+    if (!spos)
+      return false;
+    if (start && spos != str)
+      return false;
+    str = spos + len;
+    start = false;
+    asterisk = false;
+  }
+  return true;
+}
+
+int SuppressionContext::TypeIndex(const char *type) const {
+  // Callers usually pass the very strings they registered, try those first.
+  for (int i = 0; i < suppression_types_num_; i++) {
+    if (type == suppression_types_[i])
+      return i;
+  }
+  for (int i = 0; i < suppression_types_num_; i++) {
+    if (0 == internal_strcmp(type, suppression_types_[i]))
+      return i;
+  }
+  return -1;
+}
+
 bool SuppressionContext::Match(const char *str, const char *type,
                                Suppression **s) {
   can_parse_ = false;
-  if (!HasSuppressionType(type))
+  int type_index = TypeIndex(type);
+  if (type_index < 0 || !has_suppression_type_[type_index])
     return false;
   for (uptr i = 0; i < suppressions_.size(); i++) {
     Suppression &cur = suppressions_[i];
-    if (0 == internal_strcmp(cur.type, type) && TemplateMatch(cur.templ, str)) {
+    if (cur.type_index == type_index && ProgramMatch(cur.program, str)) {
       *s = &cur;
       return true;
     }
@@ -103,6 +178,79 @@ bool SuppressionContext::Match(const char *str, const char *type,
   return false;
 }
 
+SuppressionContext::PCCacheEntry *SuppressionContext::GetPCCache() {
+  uptr cache = atomic_load(&pc_cache_, memory_order_acquire);
+  if (LIKELY(cache))
+    return (PCCacheEntry *)cache;
+  uptr size = kPCCacheSize * sizeof(PCCacheEntry);
+  uptr fresh = (uptr)MmapOrDie(size, "SuppressionPCCache");
+  if (atomic_compare_exchange_strong(&pc_cache_, &cache, fresh,
+                                     memory_order_acq_rel))
+    return (PCCacheEntry *)fresh;
+  // Another thread installed its cache first.
+  UnmapOrDie((void *)fresh, size);
+  return (PCCacheEntry *)cache;
+}
+
+static u64 PCCacheKey(uptr pc, int type_index) {
+  return ((u64)pc << 6) | (u64)type_index;
+}
+
+static uptr PCCacheSlot(u64 key, uptr size) {
+  return (uptr)((key * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1);
+}
+
+bool SuppressionContext::LookupPC(uptr pc, const char *type,
+                                  Suppression **s) {
+  int type_index = TypeIndex(type);
+  if (type_index < 0 || pc == 0)
+    return false;
+  PCCacheEntry *cache = GetPCCache();
+  u64 key = PCCacheKey(pc, type_index);
+  uptr pos = PCCacheSlot(key, kPCCacheSize);
+  for (uptr probe = 0; probe < kPCCacheMaxProbes; probe++) {
+    PCCacheEntry *e = &cache[pos];
+    u64 cur = atomic_load(&e->key, memory_order_acquire);
+    if (cur == 0)
+      return false;
+    if (cur == key) {
+      u32 value = atomic_load(&e->value, memory_order_acquire);
+      if (!(value & kPCCacheValid))
+        return false;
+      value &= ~kPCCacheValid;
+      *s = value ? &suppressions_[value - 1] : nullptr;
+      return true;
+    }
+    pos = (pos + 1) & (kPCCacheSize - 1);
+  }
+  return false;
+}
+
+void SuppressionContext::CachePC(uptr pc, const char *type, Suppression *s) {
+  int type_index = TypeIndex(type);
+  if (type_index < 0 || pc == 0)
+    return;
+  PCCacheEntry *cache = GetPCCache();
+  u64 key = PCCacheKey(pc, type_index);
+  u32 value = kPCCacheValid | (s ? (u32)(s - &suppressions_[0]) + 1 : 0);
+  uptr pos = PCCacheSlot(key, kPCCacheSize);
+  for (uptr probe = 0; probe < kPCCacheMaxProbes; probe++) {
+    PCCacheEntry *e = &cache[pos];
+    u64 cur = atomic_load(&e->key, memory_order_acquire);
+    if (cur == key)
+      return;  // Another thread got there first, with the same verdict.
+    if (cur == 0 && atomic_compare_exchange_strong(&e->key, &cur, key,
+                                                   memory_order_acq_rel)) {
+      atomic_store(&e->value, value, memory_order_release);
+      return;
+    }
+    if (cur == key)
+      return;
+    pos = (pos + 1) & (kPCCacheSize - 1);
+  }
+  // The neighbourhood is full, this PC will keep going through Match().
+}
+
 static const char *StripPrefix(const char *str, const char *prefix) {
   while (*str && *str == *prefix) {
     str++;
@@ -145,6 +293,8 @@ void SuppressionContext::Parse(const char *str) {
       s.templ = (char*)InternalAlloc(end2 - line + 1);
       internal_memcpy(s.templ, line, end2 - line);
       s.templ[end2 - line] = 0;
+      s.type_index = type;
+      s.program = CompileTemplate(s.templ);
       suppressions_.push_back(s);
       has_suppression_type_[type] = true;
     }
@@ -159,11 +309,8 @@ uptr SuppressionContext::SuppressionCount() const {
 }
 
 bool SuppressionContext::HasSuppressionType(const char *type) const {
-  for (int i = 0; i < suppression_types_num_; i++) {
-    if (0 == internal_strcmp(type, suppression_types_[i]))
-      return has_suppression_type_[i];
-  }
-  return false;
+  int type_index = TypeIndex(type);
+  return type_index >= 0 && has_suppression_type_[type_index];
 }
 
 const Suppression *SuppressionContext::SuppressionAt(uptr i) const {
@@ -24,6 +24,11 @@ struct Suppression {
   char *templ;
   atomic_uint32_t hit_count;
   uptr weight;
+  // Index of type in the suppression types of the owning context.
+  int type_index;
+  // templ compiled at parse time into a sequence of operations, so that
+  // matching neither rescans nor temporarily modifies the template.
+  char *program;
 };
 
 class SuppressionContext {
@@ -36,6 +41,14 @@ class SuppressionContext {
   void Parse(const char *str);
 
   bool Match(const char *str, const char *type, Suppression **s);
+
+  // Per-PC verdict cache, for tools matching suppressions against the
+  // symbolized frames of a PC. Returns true if the verdict for (pc, type) is
+  // known, in which case *s is set to the matching suppression, or nullptr if
+  // none matched. Lookups and insertions are lock-free.
+  bool LookupPC(uptr pc, const char *type, Suppression **s);
+  void CachePC(uptr pc, const char *type, Suppression *s);
+
   uptr SuppressionCount() const;
   bool HasSuppressionType(const char *type) const;
   const Suppression *SuppressionAt(uptr i) const;
@@ -43,10 +56,24 @@ class SuppressionContext {
 
  private:
   static const int kMaxSuppressionTypes = 64;
+  static const uptr kPCCacheSize = 1 << 12;
+  static const uptr kPCCacheMaxProbes = 8;
   const char **const suppression_types_;
   const int suppression_types_num_;
 
+  struct PCCacheEntry {
+    // (pc << 6) | type index, 0 if the entry is free.
+    atomic_uint64_t key;
+    // kPCCacheValid | (suppression index + 1), or 0 while being published.
+    atomic_uint32_t value;
+  };
+  static const u32 kPCCacheValid = 1U << 31;
+
+  int TypeIndex(const char *type) const;
+  PCCacheEntry *GetPCCache();
+
   InternalMmapVector<Suppression> suppressions_;
+  atomic_uintptr_t pc_cache_;
   bool has_suppression_type_[kMaxSuppressionTypes];
   bool can_parse_;
 };
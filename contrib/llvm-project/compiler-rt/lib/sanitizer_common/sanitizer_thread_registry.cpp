@@ -102,11 +102,13 @@ void ThreadContextBase::Reset() {
 const u32 ThreadRegistry::kUnknownTid = ~0U;
 
 ThreadRegistry::ThreadRegistry(ThreadContextFactory factory, u32 max_threads,
-                               u32 thread_quarantine_size, u32 max_reuse)
+                               u32 thread_quarantine_size, u32 max_reuse,
+                               bool reuse_lowest_tid)
     : context_factory_(factory),
       max_threads_(max_threads),
       thread_quarantine_size_(thread_quarantine_size),
       max_reuse_(max_reuse),
+      reuse_lowest_tid_(reuse_lowest_tid),
       mtx_(),
       n_contexts_(0),
       total_threads_(0),
@@ -333,6 +335,21 @@ ThreadContextBase *ThreadRegistry::QuarantinePop() {
   if (invalid_threads_.size() == 0)
     return 0;
   ThreadContextBase *tctx = invalid_threads_.front();
+  if (reuse_lowest_tid_) {
+    // Thread creation is not a hot path, a linear scan will do.
+    ThreadContextBase *prev = nullptr;
+    ThreadContextBase *lowest_prev = nullptr;
+    for (ThreadContextBase *t = tctx; t; prev = t, t = t->next) {
+      if (t->tid < tctx->tid) {
+        tctx = t;
+        lowest_prev = prev;
+      }
+    }
+    if (lowest_prev) {
+      invalid_threads_.extract(lowest_prev, tctx);
+      return tctx;
+    }
+  }
   invalid_threads_.pop_front();
   return tctx;
 }
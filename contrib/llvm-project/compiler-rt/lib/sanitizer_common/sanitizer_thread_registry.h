@@ -88,8 +88,12 @@ class ThreadRegistry {
  public:
   static const u32 kUnknownTid;
 
+  // If reuse_lowest_tid is set, the lowest available tid is handed out to new
+  // threads instead of the least recently released one. This keeps the range
+  // of live tids compact, which benefits tools that keep per-tid arrays.
   ThreadRegistry(ThreadContextFactory factory, u32 max_threads,
-                 u32 thread_quarantine_size, u32 max_reuse = 0);
+                 u32 thread_quarantine_size, u32 max_reuse = 0,
+                 bool reuse_lowest_tid = false);
   void GetNumberOfThreads(uptr *total = nullptr, uptr *running = nullptr,
                           uptr *alive = nullptr);
   uptr GetMaxAliveThreads();
@@ -134,6 +138,7 @@ class ThreadRegistry {
   const u32 max_threads_;
   const u32 thread_quarantine_size_;
   const u32 max_reuse_;
+  const bool reuse_lowest_tid_;
 
   BlockingMutex mtx_;
 
@@ -17,6 +17,7 @@
 #include "secondary.h"
 #include "size_class_map.h"
 #include "tsd_exclusive.h"
+#include "tsd_percpu.h"
 #include "tsd_shared.h"
 
 namespace scudo {
@@ -33,7 +34,12 @@ struct DefaultConfig {
   typedef SizeClassAllocator32<SizeClassMap, 19U> Primary;
 #endif
   typedef MapAllocator<MapAllocatorCache<>> Secondary;
+#if SCUDO_USE_PERCPU_TSD && SCUDO_LINUX
+  template <class A>
+  using TSDRegistryT = TSDRegistryPerCPUT<A, 64U>; // Per CPU, max 64 TSDs.
+#else
   template <class A> using TSDRegistryT = TSDRegistryExT<A>; // Exclusive
+#endif
 };
 
 struct AndroidConfig {
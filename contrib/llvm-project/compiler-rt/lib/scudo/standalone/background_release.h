@@ -0,0 +1,184 @@
+//===-- background_release.h ------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SCUDO_BACKGROUND_RELEASE_H_
+#define SCUDO_BACKGROUND_RELEASE_H_
+
+#include "atomic_helpers.h"
+#include "common.h"
+#include "string_utils.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+namespace scudo {
+
+// BackgroundReleaser periodically asks the allocator to return unused Primary
+// memory to the OS from a dedicated thread, which keeps the page scans that
+// come with a release away from the deallocation path.
+//
+// The time between two passes adapts to their outcome: a pass that released a
+// meaningful amount of memory halves the interval, a fruitless one doubles it,
+// within [Base / 8, Base * 8]. When the allocator reports memory pressure, the
+// shortest interval is used and sparse regions are released as well.
+//
+// The thread waits between passes on a condition variable, so that a stop
+// request wakes it up immediately rather than at the end of the interval.
+//
+// The allocator is expected to provide:
+// - uptr releaseToOSBackground(bool UnderPressure);
+// - bool isUnderMemoryPressure();
+template <class AllocatorT> class BackgroundReleaser {
+public:
+  // Starts the release thread the first time it is called. Returns false if
+  // the thread is not running, in which case the caller must keep releasing
+  // memory inline.
+  bool startOnce(AllocatorT *A, s32 BaseIntervalMs) {
+    if (atomic_exchange(&Started, 1U, memory_order_acq_rel) != 0U)
+      return isRunning();
+    if (BaseIntervalMs <= 0)
+      return false;
+    Allocator = A;
+    const u32 Base = static_cast<u32>(BaseIntervalMs);
+    MinIntervalMs = Max(Base >> 3, MinAllowedIntervalMs);
+    MaxIntervalMs = Max(Base > (UINT32_MAX >> 3) ? UINT32_MAX : Base << 3,
+                        MinIntervalMs);
+    atomic_store_relaxed(&IntervalMs, Base);
+    atomic_store_relaxed(&StopRequested, 0U);
+    pthread_mutex_init(&WaitMutex, nullptr);
+    pthread_condattr_t Attr;
+    pthread_condattr_init(&Attr);
+    pthread_condattr_setclock(&Attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&WaitCond, &Attr);
+    pthread_condattr_destroy(&Attr);
+    if (pthread_create(&Thread, nullptr, threadStart, this) != 0)
+      return false;
+    atomic_store(&Running, 1U, memory_order_release);
+    return true;
+  }
+
+  bool isRunning() { return atomic_load(&Running, memory_order_acquire) != 0U; }
+
+  void stopTestOnly() {
+    if (!isRunning())
+      return;
+    pthread_mutex_lock(&WaitMutex);
+    atomic_store(&StopRequested, 1U, memory_order_release);
+    pthread_cond_signal(&WaitCond);
+    pthread_mutex_unlock(&WaitMutex);
+    pthread_join(Thread, nullptr);
+    pthread_cond_destroy(&WaitCond);
+    pthread_mutex_destroy(&WaitMutex);
+    atomic_store(&Running, 0U, memory_order_release);
+  }
+
+  // Returns true if a release thread was running in the parent process, and
+  // allows for a new one to be started in the child.
+  bool resetInChild() {
+    const bool WasRunning = isRunning();
+    atomic_store(&Running, 0U, memory_order_release);
+    atomic_store(&Started, 0U, memory_order_release);
+    return WasRunning;
+  }
+
+  void getStats(ScopedString *Str) {
+    if (!isRunning())
+      return;
+    Str->append("Stats: BackgroundReleaser: %zu passes (%zu under pressure); "
+                "released %zuK in %zuus; current interval: %ums\n",
+                atomic_load_relaxed(&Passes),
+                atomic_load_relaxed(&PressurePasses),
+                atomic_load_relaxed(&ReleasedBytes) >> 10,
+                static_cast<uptr>(atomic_load_relaxed(&TimeSpentNs) / 1000),
+                atomic_load_relaxed(&IntervalMs));
+  }
+
+private:
+  // Never wake up more often than this, whatever the base interval.
+  static constexpr u32 MinAllowedIntervalMs = 10U;
+  // A pass releasing fewer pages than this is not considered productive.
+  static constexpr uptr ProductivePagesCount = 16U;
+
+  static void *threadStart(void *Arg) {
+    reinterpret_cast<BackgroundReleaser *>(Arg)->run();
+    return nullptr;
+  }
+
+  // Waits for Ms milliseconds. Returns false if a stop was requested in the
+  // meantime.
+  bool waitForNextPass(u32 Ms) {
+    timespec Deadline;
+    clock_gettime(CLOCK_MONOTONIC, &Deadline);
+    Deadline.tv_sec += Ms / 1000;
+    Deadline.tv_nsec += static_cast<long>(Ms % 1000) * 1000000;
+    if (Deadline.tv_nsec >= 1000000000) {
+      Deadline.tv_sec++;
+      Deadline.tv_nsec -= 1000000000;
+    }
+    pthread_mutex_lock(&WaitMutex);
+    while (atomic_load_relaxed(&StopRequested) == 0U &&
+           pthread_cond_timedwait(&WaitCond, &WaitMutex, &Deadline) !=
+               ETIMEDOUT) {
+    }
+    const bool Stop = atomic_load_relaxed(&StopRequested) != 0U;
+    pthread_mutex_unlock(&WaitMutex);
+    return !Stop;
+  }
+
+  void run() {
+    const uptr ProductiveBytes = ProductivePagesCount * getPageSizeCached();
+    while (true) {
+      u32 Interval = atomic_load_relaxed(&IntervalMs);
+      if (!waitForNextPass(Interval))
+        break;
+      const bool UnderPressure = Allocator->isUnderMemoryPressure();
+      const u64 StartNs = getMonotonicTime();
+      const uptr Released = Allocator->releaseToOSBackground(UnderPressure);
+      const u64 SpentNs = getMonotonicTime() - StartNs;
+
+      atomic_store_relaxed(&Passes, atomic_load_relaxed(&Passes) + 1);
+      if (UnderPressure)
+        atomic_store_relaxed(&PressurePasses,
+                             atomic_load_relaxed(&PressurePasses) + 1);
+      atomic_store_relaxed(&ReleasedBytes,
+                           atomic_load_relaxed(&ReleasedBytes) + Released);
+      atomic_store_relaxed(&TimeSpentNs,
+                           atomic_load_relaxed(&TimeSpentNs) + SpentNs);
+
+      if (UnderPressure)
+        Interval = MinIntervalMs;
+      else if (Released >= ProductiveBytes)
+        Interval = Max(Interval >> 1, MinIntervalMs);
+      else if (Released == 0)
+        Interval = Min(Interval << 1, MaxIntervalMs);
+      atomic_store_relaxed(&IntervalMs, Interval);
+    }
+  }
+
+  AllocatorT *Allocator;
+  pthread_t Thread;
+  u32 MinIntervalMs;
+  u32 MaxIntervalMs;
+  atomic_u8 Started;
+  atomic_u8 Running;
+  // Protected by WaitMutex when set, so that the wake-up cannot be missed.
+  atomic_u8 StopRequested;
+  pthread_mutex_t WaitMutex;
+  pthread_cond_t WaitCond;
+  // Only written by the release thread, read by getStats().
+  atomic_u32 IntervalMs;
+  atomic_uptr Passes;
+  atomic_uptr PressurePasses;
+  atomic_uptr ReleasedBytes;
+  atomic_u64 TimeSpentNs;
+};
+
+} // namespace scudo
+
+#endif // SCUDO_BACKGROUND_RELEASE_H_
@@ -9,6 +9,7 @@
 #ifndef SCUDO_COMBINED_H_
 #define SCUDO_COMBINED_H_
 
+#include "background_release.h"
 #include "chunk.h"
 #include "common.h"
 #include "flags.h"
@@ -54,6 +55,32 @@ class Allocator {
   void callPostInitCallback() {
     static pthread_once_t OnceControl = PTHREAD_ONCE_INIT;
     pthread_once(&OnceControl, PostInitCallback);
+    if (UNLIKELY(getFlags()->background_release))
+      startBackgroundReleaseMaybe();
+  }
+
+  // The release thread is started once the allocator is fully functional, as
+  // creating a thread might require allocating memory. Until it is running,
+  // memory keeps being released inline by the deallocating threads.
+  void startBackgroundReleaseMaybe() {
+    if (Releaser.startOnce(this, getFlags()->release_to_os_interval_ms))
+      Primary.setBackgroundRelease(true);
+  }
+
+  uptr releaseToOSBackground(bool UnderPressure) {
+    return Primary.releaseToOSBackground(UnderPressure);
+  }
+
+  // We consider the process to be under memory pressure when the mapped memory
+  // exceeds 3/4 of the RSS limit, if any.
+  bool isUnderMemoryPressure() {
+    const s32 RssLimitMb = getFlags()->rss_limit_mb;
+    if (RssLimitMb <= 0)
+      return false;
+    const uptr LimitBytes = static_cast<uptr>(RssLimitMb) << 20;
+    StatCounters S;
+    Stats.get(S);
+    return S[StatMapped] >= LimitBytes - (LimitBytes >> 2);
   }
 
   struct QuarantineCallback {
@@ -199,6 +226,7 @@ class Allocator {
   void reset() { memset(this, 0, sizeof(*this)); }
 
   void unmapTestOnly() {
+    Releaser.stopTestOnly();
     TSDRegistry.unmapTestOnly();
     Primary.unmapTestOnly();
 #ifdef GWP_ASAN_HOOKS
@@ -603,6 +631,14 @@ class Allocator {
 #endif
   }
 
+  // Only the forking thread survives in the child: if a release thread was
+  // running, go back to releasing memory inline until a new one is started.
+  void enableInChild() {
+    enable();
+    if (Releaser.resetInChild())
+      Primary.setBackgroundRelease(false);
+  }
+
   // The function returns the amount of bytes required to store the statistics,
   // which might be larger than the amount of bytes provided. Note that the
   // statistics buffer is not necessarily constant between calls to this
@@ -908,6 +944,7 @@ class Allocator {
   PrimaryT Primary;
   SecondaryT Secondary;
   QuarantineT Quarantine;
+  BackgroundReleaser<ThisT> Releaser;
 
   u32 Cookie;
 
@@ -1061,6 +1098,7 @@ class Allocator {
 
   uptr getStats(ScopedString *Str) {
     Primary.getStats(Str);
+    Releaser.getStats(Str);
     Secondary.getStats(Str);
     Quarantine.getStats(Str);
     return Str->length();
@@ -129,6 +129,11 @@ inline uptr getPageSizeCached() {
 // Returns 0 if the number of CPUs could not be determined.
 u32 getNumberOfCPUs();
 
+// Returns the index of the CPU the calling thread is currently running on, or
+// -1 if it cannot be determined. The thread might be migrated right after, so
+// the result is only a hint.
+s32 getCurrentCPU();
+
 const char *getEnv(const char *Name);
 
 u64 getMonotonicTime();
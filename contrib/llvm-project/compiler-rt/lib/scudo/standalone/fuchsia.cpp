@@ -170,6 +170,8 @@ u64 getMonotonicTime() { return _zx_clock_get_monotonic(); }
 
 u32 getNumberOfCPUs() { return _zx_system_get_num_cpus(); }
 
+s32 getCurrentCPU() { return -1; }
+
 u32 getThreadID() { return 0; }
 
 bool getRandom(void *Buffer, uptr Length, UNUSED bool Blocking) {
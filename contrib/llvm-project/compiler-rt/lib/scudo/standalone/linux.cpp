@@ -130,6 +130,47 @@ u64 getMonotonicTime() {
          static_cast<u64>(TS.tv_nsec);
 }
 
+// Registering a restartable sequences area for the thread lets the kernel keep
+// the current CPU number up to date in memory, turning getCurrentCPU() into a
+// plain load. If the registration fails (unsupported kernel, or the C library
+// already registered its own area), we fall back to sched_getcpu().
+#if defined(__NR_rseq)
+namespace {
+struct alignas(32) RseqArea {
+  u32 CpuIdStart;
+  u32 CpuId;
+  u64 RseqCs;
+  u32 Flags;
+};
+enum RseqState : u8 { RseqUnknown = 0, RseqRegistered, RseqUnavailable };
+constexpr u32 RseqSignature = 0x53053053;
+} // namespace
+
+static THREADLOCAL RseqArea ThreadRseq;
+static THREADLOCAL RseqState ThreadRseqState;
+
+static NOINLINE bool registerRseq() {
+  ThreadRseq.CpuId = static_cast<u32>(-1);
+  return syscall(__NR_rseq, &ThreadRseq, sizeof(ThreadRseq), 0,
+                 RseqSignature) == 0;
+}
+#endif
+
+s32 getCurrentCPU() {
+#if defined(__NR_rseq)
+  if (LIKELY(ThreadRseqState == RseqRegistered))
+    return static_cast<s32>(
+        __atomic_load_n(&ThreadRseq.CpuId, __ATOMIC_RELAXED));
+  if (ThreadRseqState == RseqUnknown) {
+    ThreadRseqState = registerRseq() ? RseqRegistered : RseqUnavailable;
+    if (ThreadRseqState == RseqRegistered)
+      return static_cast<s32>(
+          __atomic_load_n(&ThreadRseq.CpuId, __ATOMIC_RELAXED));
+  }
+#endif
+  return sched_getcpu();
+}
+
 u32 getNumberOfCPUs() {
   cpu_set_t CPUs;
   // sched_getaffinity can fail for a variety of legitimate reasons (lack of
@@ -47,6 +47,13 @@
 #define SCUDO_CAN_USE_PRIMARY64 (SCUDO_WORDSIZE == 64U)
 #endif
 
+// Associate the thread specific data contexts with CPUs rather than threads
+// in the default configuration, see tsd_percpu.h. Only Linux provides a cheap
+// way to get the current CPU number.
+#ifndef SCUDO_USE_PERCPU_TSD
+#define SCUDO_USE_PERCPU_TSD 0
+#endif
+
 #ifndef SCUDO_MIN_ALIGNMENT_LOG
 // We force malloc-type functions to be aligned to std::max_align_t, but there
 // is no reason why the minimum alignment for all other functions can't be 8
@@ -127,7 +127,7 @@ class SizeClassAllocator32 {
     ScopedLock L(Sci->Mutex);
     Sci->FreeList.push_front(B);
     Sci->Stats.PushedBlocks += B->getCount();
-    if (Sci->CanRelease)
+    if (Sci->CanRelease && !usesBackgroundRelease())
       releaseToOSMaybe(Sci, ClassId);
   }
 
@@ -203,6 +203,27 @@ class SizeClassAllocator32 {
     return TotalReleasedBytes;
   }
 
+  // See SizeClassAllocator64 for the semantics of the background release.
+  void setBackgroundRelease(bool Enabled) {
+    atomic_store_relaxed(&BackgroundRelease, Enabled ? 1U : 0U);
+  }
+  bool usesBackgroundRelease() {
+    return atomic_load_relaxed(&BackgroundRelease) != 0U;
+  }
+
+  uptr releaseToOSBackground(bool UnderPressure) {
+    uptr TotalReleasedBytes = 0;
+    for (uptr I = 0; I < NumClasses; I++) {
+      SizeClassInfo *Sci = getSizeClassInfo(I);
+      if (!Sci->CanRelease || !Sci->Mutex.tryLock())
+        continue;
+      if (UnderPressure || hasReleasableDensity(Sci, I))
+        TotalReleasedBytes += releaseToOSMaybe(Sci, I, /*Force=*/true);
+      Sci->Mutex.unlock();
+    }
+    return TotalReleasedBytes;
+  }
+
   bool useMemoryTagging() { return false; }
   void disableMemoryTagging() {}
 
@@ -220,6 +241,7 @@ class SizeClassAllocator32 {
   static const uptr RegionSize = 1UL << RegionSizeLog;
   static const uptr NumRegions = SCUDO_MMAP_RANGE_SIZE >> RegionSizeLog;
   static const u32 MaxNumBatches = SCUDO_ANDROID ? 4U : 8U;
+  static const uptr MinFreeDensityLog = 3U;
   typedef FlatByteMap<NumRegions> ByteMap;
 
   struct SizeClassStats {
@@ -232,6 +254,8 @@ class SizeClassAllocator32 {
     uptr RangesReleased;
     uptr LastReleasedBytes;
     u64 LastReleaseAtNs;
+    uptr TotalReleasedBytes;
+    u64 TotalReleaseTimeNs;
   };
 
   struct alignas(SCUDO_CACHE_LINE_SIZE) SizeClassInfo {
@@ -417,16 +441,29 @@ class SizeClassAllocator32 {
     const uptr InUse = Sci->Stats.PoppedBlocks - Sci->Stats.PushedBlocks;
     const uptr AvailableChunks = Sci->AllocatedUser / getSizeByClassId(ClassId);
     Str->append("  %02zu (%6zu): mapped: %6zuK popped: %7zu pushed: %7zu "
-                "inuse: %6zu avail: %6zu rss: %6zuK releases: %6zu\n",
+                "inuse: %6zu avail: %6zu rss: %6zuK releases: %6zu total "
+                "released: %6zuK (%zuus)\n",
                 ClassId, getSizeByClassId(ClassId), Sci->AllocatedUser >> 10,
                 Sci->Stats.PoppedBlocks, Sci->Stats.PushedBlocks, InUse,
-                AvailableChunks, Rss >> 10, Sci->ReleaseInfo.RangesReleased);
+                AvailableChunks, Rss >> 10, Sci->ReleaseInfo.RangesReleased,
+                Sci->ReleaseInfo.TotalReleasedBytes >> 10,
+                static_cast<uptr>(Sci->ReleaseInfo.TotalReleaseTimeNs / 1000));
   }
 
   s32 getReleaseToOsIntervalMs() {
     return atomic_load(&ReleaseToOsIntervalMs, memory_order_relaxed);
   }
 
+  bool hasReleasableDensity(SizeClassInfo *Sci, uptr ClassId) {
+    const uptr BlockSize = getSizeByClassId(ClassId);
+    const uptr InUseBytes =
+        (Sci->Stats.PoppedBlocks - Sci->Stats.PushedBlocks) * BlockSize;
+    if (InUseBytes >= Sci->AllocatedUser)
+      return false;
+    const uptr BytesInFreeList = Sci->AllocatedUser - InUseBytes;
+    return BytesInFreeList >= (Sci->AllocatedUser >> MinFreeDensityLog);
+  }
+
   NOINLINE uptr releaseToOSMaybe(SizeClassInfo *Sci, uptr ClassId,
                                  bool Force = false) {
     const uptr BlockSize = getSizeByClassId(ClassId);
@@ -458,6 +495,7 @@ class SizeClassAllocator32 {
     // TODO(kostyak): currently not ideal as we loop over all regions and
     // iterate multiple times over the same freelist if a ClassId spans multiple
     // regions. But it will have to do for now.
+    const u64 StartNs = getMonotonicTime();
     uptr TotalReleasedBytes = 0;
     const uptr MaxSize = (RegionSize / BlockSize) * BlockSize;
     for (uptr I = MinRegionIndex; I <= MaxRegionIndex; I++) {
@@ -480,6 +518,9 @@ class SizeClassAllocator32 {
       }
     }
     Sci->ReleaseInfo.LastReleaseAtNs = getMonotonicTime();
+    Sci->ReleaseInfo.TotalReleasedBytes += TotalReleasedBytes;
+    Sci->ReleaseInfo.TotalReleaseTimeNs +=
+        Sci->ReleaseInfo.LastReleaseAtNs - StartNs;
     return TotalReleasedBytes;
   }
 
@@ -492,6 +533,7 @@ class SizeClassAllocator32 {
   uptr MinRegionIndex;
   uptr MaxRegionIndex;
   atomic_s32 ReleaseToOsIntervalMs;
+  atomic_u8 BackgroundRelease;
   // Unless several threads request regions simultaneously from different size
   // classes, the stash rarely contains more than 1 entry.
   static constexpr uptr MaxStashedRegions = 4;
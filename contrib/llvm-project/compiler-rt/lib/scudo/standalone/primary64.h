@@ -128,7 +128,7 @@ class SizeClassAllocator64 {
     ScopedLock L(Region->Mutex);
     Region->FreeList.push_front(B);
     Region->Stats.PushedBlocks += B->getCount();
-    if (Region->CanRelease)
+    if (Region->CanRelease && !usesBackgroundRelease())
       releaseToOSMaybe(Region, ClassId);
   }
 
@@ -204,6 +204,34 @@ class SizeClassAllocator64 {
     return TotalReleasedBytes;
   }
 
+  // When background release is enabled, pushBatch() no longer attempts to
+  // release memory inline, and releaseToOSBackground() is expected to be
+  // called periodically from a dedicated thread instead.
+  void setBackgroundRelease(bool Enabled) {
+    atomic_store_relaxed(&BackgroundRelease, Enabled ? 1U : 0U);
+  }
+  bool usesBackgroundRelease() {
+    return atomic_load_relaxed(&BackgroundRelease) != 0U;
+  }
+
+  // Releases the regions that have a high enough density of free pages. The
+  // caller is in charge of pacing the calls, so the release interval is not
+  // checked. Regions currently locked by another thread are skipped, they will
+  // be looked at during the next pass. Under memory pressure, all the
+  // releasable regions are processed regardless of their density.
+  uptr releaseToOSBackground(bool UnderPressure) {
+    uptr TotalReleasedBytes = 0;
+    for (uptr I = 0; I < NumClasses; I++) {
+      RegionInfo *Region = getRegionInfo(I);
+      if (!Region->CanRelease || !Region->Mutex.tryLock())
+        continue;
+      if (UnderPressure || hasReleasableDensity(Region, I))
+        TotalReleasedBytes += releaseToOSMaybe(Region, I, /*Force=*/true);
+      Region->Mutex.unlock();
+    }
+    return TotalReleasedBytes;
+  }
+
   bool useMemoryTagging() const {
     return SupportsMemoryTagging && UseMemoryTagging;
   }
@@ -270,6 +298,9 @@ class SizeClassAllocator64 {
   static const uptr MapSizeIncrement = 1UL << 18;
   // Fill at most this number of batches from the newly map'd memory.
   static const u32 MaxNumBatches = SCUDO_ANDROID ? 4U : 8U;
+  // Minimum fraction (as a power of two) of the user memory of a region that
+  // must be sitting in the free list for a background release to be attempted.
+  static const uptr MinFreeDensityLog = 3U;
 
   struct RegionStats {
     uptr PoppedBlocks;
@@ -281,6 +312,8 @@ class SizeClassAllocator64 {
     uptr RangesReleased;
     uptr LastReleasedBytes;
     u64 LastReleaseAtNs;
+    uptr TotalReleasedBytes;
+    u64 TotalReleaseTimeNs;
   };
 
   struct UnpaddedRegionInfo {
@@ -305,6 +338,7 @@ class SizeClassAllocator64 {
   uptr PrimaryBase;
   MapPlatformData Data;
   atomic_s32 ReleaseToOsIntervalMs;
+  atomic_u8 BackgroundRelease;
   bool UseMemoryTagging;
   alignas(SCUDO_CACHE_LINE_SIZE) RegionInfo RegionInfoArray[NumClasses];
 
@@ -428,19 +462,35 @@ class SizeClassAllocator64 {
     const uptr TotalChunks = Region->AllocatedUser / getSizeByClassId(ClassId);
     Str->append("%s %02zu (%6zu): mapped: %6zuK popped: %7zu pushed: %7zu "
                 "inuse: %6zu total: %6zu rss: %6zuK releases: %6zu last "
-                "released: %6zuK region: 0x%zx (0x%zx)\n",
+                "released: %6zuK total released: %6zuK (%zuus) region: 0x%zx "
+                "(0x%zx)\n",
                 Region->Exhausted ? "F" : " ", ClassId,
                 getSizeByClassId(ClassId), Region->MappedUser >> 10,
                 Region->Stats.PoppedBlocks, Region->Stats.PushedBlocks, InUse,
                 TotalChunks, Rss >> 10, Region->ReleaseInfo.RangesReleased,
-                Region->ReleaseInfo.LastReleasedBytes >> 10, Region->RegionBeg,
-                getRegionBaseByClassId(ClassId));
+                Region->ReleaseInfo.LastReleasedBytes >> 10,
+                Region->ReleaseInfo.TotalReleasedBytes >> 10,
+                static_cast<uptr>(Region->ReleaseInfo.TotalReleaseTimeNs / 1000),
+                Region->RegionBeg, getRegionBaseByClassId(ClassId));
   }
 
   s32 getReleaseToOsIntervalMs() {
     return atomic_load(&ReleaseToOsIntervalMs, memory_order_relaxed);
   }
 
+  // Scanning a region whose free list only covers a small fraction of its
+  // pages is unlikely to find entirely free pages, so the background releaser
+  // leaves those alone unless under memory pressure.
+  bool hasReleasableDensity(RegionInfo *Region, uptr ClassId) {
+    const uptr BlockSize = getSizeByClassId(ClassId);
+    const uptr InUseBytes =
+        (Region->Stats.PoppedBlocks - Region->Stats.PushedBlocks) * BlockSize;
+    if (InUseBytes >= Region->AllocatedUser)
+      return false;
+    const uptr BytesInFreeList = Region->AllocatedUser - InUseBytes;
+    return BytesInFreeList >= (Region->AllocatedUser >> MinFreeDensityLog);
+  }
+
   NOINLINE uptr releaseToOSMaybe(RegionInfo *Region, uptr ClassId,
                                  bool Force = false) {
     const uptr BlockSize = getSizeByClassId(ClassId);
@@ -469,6 +519,7 @@ class SizeClassAllocator64 {
       }
     }
 
+    const u64 StartNs = getMonotonicTime();
     ReleaseRecorder Recorder(Region->RegionBeg, &Region->Data);
     releaseFreeMemoryToOS(Region->FreeList, Region->RegionBeg,
                           Region->AllocatedUser, BlockSize, &Recorder);
@@ -478,8 +529,11 @@ class SizeClassAllocator64 {
           Region->Stats.PushedBlocks;
       Region->ReleaseInfo.RangesReleased += Recorder.getReleasedRangesCount();
       Region->ReleaseInfo.LastReleasedBytes = Recorder.getReleasedBytes();
+      Region->ReleaseInfo.TotalReleasedBytes += Recorder.getReleasedBytes();
     }
     Region->ReleaseInfo.LastReleaseAtNs = getMonotonicTime();
+    Region->ReleaseInfo.TotalReleaseTimeNs +=
+        Region->ReleaseInfo.LastReleaseAtNs - StartNs;
     return Recorder.getReleasedBytes();
   }
 };
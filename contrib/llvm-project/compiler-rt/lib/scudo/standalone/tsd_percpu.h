@@ -0,0 +1,136 @@
+//===-- tsd_percpu.h --------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SCUDO_TSD_PERCPU_H_
+#define SCUDO_TSD_PERCPU_H_
+
+#include "tsd.h"
+
+namespace scudo {
+
+// A TSD registry where contexts are associated to CPUs rather than threads.
+//
+// With the exclusive registry, memory cached by the TSDs grows with the number
+// of threads, while the shared registry assigns contexts to threads once and
+// for all, which leads to contention when many threads end up on the same one.
+// Here, a thread picks the context of the CPU it is running on at the time of
+// each operation, so that as long as threads are not migrated mid-operation,
+// the lock of a context is uncontended regardless of the number of threads.
+//
+// The CPU number is obtained through getCurrentCPU(), which relies on
+// restartable sequences on Linux when available. Contexts are still locked as
+// a thread might be preempted or migrated while holding one. If the CPU number
+// cannot be determined, threads fall back to a context assigned in a
+// round-robin fashion, similarly to the shared registry.
+//
+// The number of contexts is the number of CPUs available to the process,
+// capped to MaxTSDCount, and they are mapped at initialization time.
+template <class Allocator, u32 MaxTSDCount> struct TSDRegistryPerCPUT {
+  void initLinkerInitialized(Allocator *Instance) {
+    Instance->initLinkerInitialized();
+    const u32 NumberOfCPUs = getNumberOfCPUs();
+    NumberOfTSDs = NumberOfCPUs == 0 ? Min(4U, MaxTSDCount)
+                                     : Min(NumberOfCPUs, MaxTSDCount);
+    TSDsSize = roundUpTo(NumberOfTSDs * sizeof(TSD<Allocator>),
+                         getPageSizeCached());
+    TSDs = reinterpret_cast<TSD<Allocator> *>(
+        map(nullptr, TSDsSize, "scudo:tsds"));
+    for (u32 I = 0; I < NumberOfTSDs; I++)
+      TSDs[I].initLinkerInitialized(Instance);
+    Initialized = true;
+  }
+  void init(Allocator *Instance) {
+    memset(this, 0, sizeof(*this));
+    initLinkerInitialized(Instance);
+  }
+
+  void unmapTestOnly() {
+    ThreadIndex = 0;
+    unmap(reinterpret_cast<void *>(TSDs), TSDsSize);
+  }
+
+  ALWAYS_INLINE void initThreadMaybe(Allocator *Instance,
+                                     UNUSED bool MinimalInit) {
+    if (LIKELY(ThreadIndex != 0))
+      return;
+    initThread(Instance);
+  }
+
+  ALWAYS_INLINE TSD<Allocator> *getTSDAndLock(bool *UnlockRequired) {
+    DCHECK_NE(ThreadIndex, 0);
+    *UnlockRequired = true;
+    const s32 CPU = getCurrentCPU();
+    const u32 Index =
+        LIKELY(CPU >= 0) ? static_cast<u32>(CPU) : ThreadIndex - 1;
+    TSD<Allocator> *TSD = &TSDs[Index % NumberOfTSDs];
+    if (LIKELY(TSD->tryLock()))
+      return TSD;
+    return getTSDAndLockSlow(TSD);
+  }
+
+  void disable() {
+    Mutex.lock();
+    for (u32 I = 0; I < NumberOfTSDs; I++)
+      TSDs[I].lock();
+  }
+
+  void enable() {
+    for (s32 I = static_cast<s32>(NumberOfTSDs - 1); I >= 0; I--)
+      TSDs[I].unlock();
+    Mutex.unlock();
+  }
+
+private:
+  void initOnceMaybe(Allocator *Instance) {
+    ScopedLock L(Mutex);
+    if (LIKELY(Initialized))
+      return;
+    initLinkerInitialized(Instance); // Sets Initialized.
+  }
+
+  NOINLINE void initThread(Allocator *Instance) {
+    initOnceMaybe(Instance);
+    // The fallback context is assigned in a plain round-robin fashion. The
+    // index is stored off by one so that 0 means uninitialized.
+    const u32 Index = atomic_fetch_add(&CurrentIndex, 1U, memory_order_relaxed);
+    ThreadIndex = (Index % NumberOfTSDs) + 1;
+    Instance->callPostInitCallback();
+  }
+
+  // The context of the current CPU is held by another thread, which was likely
+  // preempted or migrated while holding it. Try the neighbouring contexts
+  // before waiting on the original one.
+  NOINLINE TSD<Allocator> *getTSDAndLockSlow(TSD<Allocator> *CurrentTSD) {
+    if (MaxTSDCount > 1U && NumberOfTSDs > 1U) {
+      u32 Index = static_cast<u32>(CurrentTSD - TSDs);
+      for (u32 I = 0; I < Min(4U, NumberOfTSDs - 1); I++) {
+        if (++Index == NumberOfTSDs)
+          Index = 0;
+        if (TSDs[Index].tryLock())
+          return &TSDs[Index];
+      }
+    }
+    CurrentTSD->lock();
+    return CurrentTSD;
+  }
+
+  atomic_u32 CurrentIndex;
+  u32 NumberOfTSDs;
+  uptr TSDsSize;
+  bool Initialized;
+  HybridMutex Mutex;
+  TSD<Allocator> *TSDs;
+  static THREADLOCAL u32 ThreadIndex;
+};
+
+template <class Allocator, u32 MaxTSDCount>
+THREADLOCAL u32 TSDRegistryPerCPUT<Allocator, MaxTSDCount>::ThreadIndex;
+
+} // namespace scudo
+
+#endif // SCUDO_TSD_PERCPU_H_
@@ -147,6 +147,11 @@ void ThreadClock::acquire(ClockCache *c, SyncClock *src) {
     return;
   }
 
+  // Highest index + 1 of the elements updated by this acquire. The thread
+  // clock only grows up to it, rather than up to the size of src: clocks of
+  // threads that only synchronize with a few low tids stay small, and so do
+  // the sync clocks they subsequently release to.
+  uptr top = nclk_;
   bool acquired = false;
   for (unsigned i = 0; i < kDirtyTids; i++) {
     SyncClock::Dirty dirty = src->dirty_[i];
@@ -154,6 +159,7 @@ void ThreadClock::acquire(ClockCache *c, SyncClock *src) {
     if (tid != kInvalidTid) {
       if (clk_[tid] < dirty.epoch) {
         clk_[tid] = dirty.epoch;
+        top = max(top, (uptr)tid + 1);
         acquired = true;
       }
     }
@@ -163,21 +169,25 @@ void ThreadClock::acquire(ClockCache *c, SyncClock *src) {
   if (tid_ >= nclk || src->elem(tid_).reused != reused_) {
     // O(N) acquire.
     CPP_STAT_INC(StatClockAcquireFull);
-    nclk_ = max(nclk_, nclk);
     u64 *dst_pos = &clk_[0];
+    u64 *top_pos = &clk_[top];
     for (ClockElem &src_elem : *src) {
       u64 epoch = src_elem.epoch;
       if (*dst_pos < epoch) {
         *dst_pos = epoch;
         acquired = true;
+        if (dst_pos >= top_pos)
+          top_pos = dst_pos + 1;
       }
       dst_pos++;
     }
+    top = top_pos - &clk_[0];
 
     // Remember that this thread has acquired this clock.
     if (nclk > tid_)
       src->elem(tid_).reused = reused_;
   }
+  nclk_ = top;
 
   if (acquired) {
     CPP_STAT_INC(StatClockAcquiredSomething);
@@ -93,13 +93,19 @@ static const u32 kThreadQuarantineSize = 16;
 static const u32 kThreadQuarantineSize = 64;
 #endif
 
+// Vector clocks are sized by the highest tid they have seen, so reusing the
+// lowest dead tid first keeps acquire/release cost proportional to the number
+// of live threads rather than to the number of threads ever created.
+static const bool kReuseLowestTid = true;
+
 Context::Context()
   : initialized()
   , report_mtx(MutexTypeReport, StatMtxReport)
   , nreported()
   , nmissed_expected()
   , thread_registry(new(thread_registry_placeholder) ThreadRegistry(
-      CreateThreadContext, kMaxTid, kThreadQuarantineSize, kMaxTidReuse))
+      CreateThreadContext, kMaxTid, kThreadQuarantineSize, kMaxTidReuse,
+      kReuseLowestTid))
   , racy_mtx(MutexTypeRacy, StatMtxRacy)
   , racy_stacks()
   , racy_addresses()
@@ -449,12 +449,67 @@ static bool FindRacyStacks(const RacyStacks &hash) {
   return false;
 }
 
+// Fingerprints of the stack pairs of already reported races, looked up and
+// inserted without locks so that threads hitting the same races over and over
+// do not serialize on racy_mtx nor scan racy_stacks linearly. 0 denotes an
+// empty slot. Once the table is 3/4 full, new stack pairs are recorded in
+// ctx->racy_stacks instead.
+static const uptr kRacyStacksTableSize = 1 << 14;
+static const uptr kRacyStacksTableMaxProbes = 16;
+static atomic_uint64_t racy_stacks_table[kRacyStacksTableSize];
+static atomic_uintptr_t racy_stacks_table_used;
+
+static u64 RacyStacksFingerprint(const RacyStacks &hash) {
+  // The stack pair is unordered (see RacyStacks::operator==).
+  u64 h0 = hash.hash[0].hash[0] ^ (hash.hash[0].hash[1] * 0x9E3779B97F4A7C15ull);
+  u64 h1 = hash.hash[1].hash[0] ^ (hash.hash[1].hash[1] * 0x9E3779B97F4A7C15ull);
+  if (h0 > h1)
+    Swap(h0, h1);
+  u64 fp = h0 ^ (h1 * 0xC2B2AE3D27D4EB4Full + (h1 >> 29));
+  return fp ? fp : 1;
+}
+
+// Returns true if fp was already in the table, otherwise tries to insert it
+// and sets *full if there was no room for it.
+static bool RacyStacksTableFindOrInsert(u64 fp, bool *full) {
+  uptr pos = fp & (kRacyStacksTableSize - 1);
+  for (uptr probe = 0; probe < kRacyStacksTableMaxProbes; probe++) {
+    atomic_uint64_t *slot = &racy_stacks_table[pos];
+    u64 cur = atomic_load(slot, memory_order_acquire);
+    if (cur == fp)
+      return true;
+    if (cur == 0) {
+      if (atomic_load_relaxed(&racy_stacks_table_used) >=
+          kRacyStacksTableSize / 4 * 3)
+        break;
+      if (atomic_compare_exchange_strong(slot, &cur, fp,
+                                         memory_order_acq_rel)) {
+        atomic_fetch_add(&racy_stacks_table_used, 1, memory_order_relaxed);
+        return false;
+      }
+      // Lost the race for the slot, cur holds the winner's fingerprint.
+      if (cur == fp)
+        return true;
+    }
+    pos = (pos + 1) & (kRacyStacksTableSize - 1);
+  }
+  *full = true;
+  return false;
+}
+
 static bool HandleRacyStacks(ThreadState *thr, VarSizeStackTrace traces[2]) {
   if (!flags()->suppress_equal_stacks)
     return false;
   RacyStacks hash;
   hash.hash[0] = md5_hash(traces[0].trace, traces[0].size * sizeof(uptr));
   hash.hash[1] = md5_hash(traces[1].trace, traces[1].size * sizeof(uptr));
+  bool full = false;
+  if (RacyStacksTableFindOrInsert(RacyStacksFingerprint(hash), &full)) {
+    VPrintf(2, "ThreadSanitizer: suppressing report as doubled (stack)\n");
+    return true;
+  }
+  if (!full)
+    return false;
   {
     ReadLock lock(&ctx->racy_mtx);
     if (FindRacyStacks(hash))
@@ -679,6 +734,14 @@ void ReportRace(ThreadState *thr) {
     }
   }
 
+  // Drop the reports already known to be suppressed before paying for the
+  // symbolization of their stacks.
+  for (uptr i = 0; i < kMop; i++) {
+    Suppression *supp = nullptr;
+    if (IsSuppressedCached(typ, traces[i], &supp))
+      return;
+  }
+
   ThreadRegistryLock l0(ctx->thread_registry);
   ScopedReport rep(typ, tag);
   for (uptr i = 0; i < kMop; i++) {
@@ -91,18 +91,52 @@ static const char *conv(ReportType typ) {
   UNREACHABLE("missing case");
 }
 
+static bool MatchFrame(const char *stype, const AddressInfo &info,
+                       Suppression **sp) {
+  return suppression_ctx->Match(info.function, stype, sp) ||
+         suppression_ctx->Match(info.file, stype, sp) ||
+         suppression_ctx->Match(info.module, stype, sp);
+}
+
+static uptr Suppressed(Suppression *s, uptr pc, Suppression **sp) {
+  VPrintf(2, "ThreadSanitizer: matched suppression '%s'\n", s->templ);
+  atomic_fetch_add(&s->hit_count, 1, memory_order_relaxed);
+  *sp = s;
+  return pc;
+}
+
 static uptr IsSuppressed(const char *stype, const AddressInfo &info,
     Suppression **sp) {
-  if (suppression_ctx->Match(info.function, stype, sp) ||
-      suppression_ctx->Match(info.file, stype, sp) ||
-      suppression_ctx->Match(info.module, stype, sp)) {
-    VPrintf(2, "ThreadSanitizer: matched suppression '%s'\n", (*sp)->templ);
-    atomic_fetch_add(&(*sp)->hit_count, 1, memory_order_relaxed);
-    return info.address;
-  }
+  if (MatchFrame(stype, info, sp))
+    return Suppressed(*sp, info.address, sp);
   return 0;
 }
 
+// Matches the frames starting at *frame that share its PC (that is, the
+// frames inlined at that PC), and advances *frame past them. The verdict only
+// depends on the PC, so it is cached to skip symbol matching the next time
+// the PC shows up in a report.
+static uptr IsSuppressedPC(const char *stype, const SymbolizedStack **frame,
+                           Suppression **sp) {
+  const SymbolizedStack *first = *frame;
+  uptr pc = first->info.address;
+  const SymbolizedStack *end = first->next;
+  while (end && end->info.address == pc)
+    end = end->next;
+  *frame = end;
+  Suppression *s;
+  if (suppression_ctx->LookupPC(pc, stype, &s))
+    return s ? Suppressed(s, pc, sp) : 0;
+  s = nullptr;
+  for (const SymbolizedStack *f = first; f != end; f = f->next) {
+    if (MatchFrame(stype, f->info, &s))
+      break;
+    s = nullptr;
+  }
+  suppression_ctx->CachePC(pc, stype, s);
+  return s ? Suppressed(s, pc, sp) : 0;
+}
+
 uptr IsSuppressed(ReportType typ, const ReportStack *stack, Suppression **sp) {
   CHECK(suppression_ctx);
   if (!suppression_ctx->SuppressionCount() || stack == 0 ||
@@ -111,9 +145,8 @@ uptr IsSuppressed(ReportType typ, const ReportStack *stack, Suppression **sp) {
   const char *stype = conv(typ);
   if (0 == internal_strcmp(stype, kSuppressionNone))
     return 0;
-  for (const SymbolizedStack *frame = stack->frames; frame;
-      frame = frame->next) {
-    uptr pc = IsSuppressed(stype, frame->info, sp);
+  for (const SymbolizedStack *frame = stack->frames; frame;) {
+    uptr pc = IsSuppressedPC(stype, &frame, sp);
     if (pc != 0)
       return pc;
   }
@@ -122,6 +155,25 @@ uptr IsSuppressed(ReportType typ, const ReportStack *stack, Suppression **sp) {
   return 0;
 }
 
+// Looks up the raw PCs of a stack that was not symbolized yet in the verdicts
+// cached by IsSuppressed(). A stack is suppressed if any of its frames is, so
+// a single PC known to be suppressed is enough to drop the report without
+// symbolizing it. Otherwise, the report goes through IsSuppressed() as usual.
+uptr IsSuppressedCached(ReportType typ, StackTrace trace, Suppression **sp) {
+  CHECK(suppression_ctx);
+  if (!suppression_ctx->SuppressionCount())
+    return 0;
+  const char *stype = conv(typ);
+  if (0 == internal_strcmp(stype, kSuppressionNone))
+    return 0;
+  for (uptr i = 0; i < trace.size; i++) {
+    Suppression *s;
+    if (suppression_ctx->LookupPC(trace.trace[i], stype, &s) && s)
+      return Suppressed(s, trace.trace[i], sp);
+  }
+  return 0;
+}
+
 uptr IsSuppressed(ReportType typ, const ReportLocation *loc, Suppression **sp) {
   CHECK(suppression_ctx);
   if (!suppression_ctx->SuppressionCount() || loc == 0 ||
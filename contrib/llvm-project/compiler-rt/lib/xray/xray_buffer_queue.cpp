@@ -65,46 +65,120 @@ struct ExtentsPadded {
 
 constexpr size_t kExtentsSize = sizeof(ExtentsPadded);
 
+// Set in ReadPos and WritePos while the ring is closed, so that claims based
+// on a position read before fail.
+constexpr atomic_uint64_t::Type kRingClosed = 1ULL << 63;
+
+atomic_uint64_t::Type closePosition(atomic_uint64_t *P) {
+  auto V = atomic_load(P, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak(P, &V, V | kRingClosed,
+                                       memory_order_acq_rel)) {
+  }
+  return V;
+}
+
 } // namespace
 
+BufferQueue::Ring *BufferQueue::allocRing(size_t Capacity) {
+  auto R = reinterpret_cast<Ring *>(
+      allocateBuffer(sizeof(Ring) + Capacity * sizeof(BufferRep)));
+  if (R != nullptr)
+    R->Capacity = Capacity;
+  return R;
+}
+
+void BufferQueue::deallocRing(Ring *R) {
+  if (R == nullptr)
+    return;
+  deallocateBuffer(reinterpret_cast<unsigned char *>(R),
+                   sizeof(Ring) + R->Capacity * sizeof(BufferRep));
+}
+
+void BufferQueue::closeRing(atomic_uint64_t::Type &Read,
+                            atomic_uint64_t::Type &Write) {
+  Read = closePosition(&ReadPos);
+  Write = closePosition(&WritePos);
+  if (Buffers == nullptr || BufferCount == 0)
+    return;
+
+  // Every position in [Read, Read + BufferCount) maps to its own slot, which
+  // holds a buffer to be read at it if it is below Write, and is otherwise
+  // empty awaiting a write at it. Slots that do not match are still being
+  // read from or written to.
+  for (auto Pos = Read; Pos != Read + BufferCount; ++Pos) {
+    auto Expected = Pos < Write ? 2 * Pos + 1 : 2 * Pos;
+    auto &Slot = Buffers[Pos % BufferCount];
+    while (atomic_load(&Slot.Sequence, memory_order_acquire) != Expected)
+      internal_sched_yield();
+  }
+}
+
+void BufferQueue::openRing(atomic_uint64_t::Type Read,
+                           atomic_uint64_t::Type Write) {
+  atomic_store(&WritePos, Write, memory_order_release);
+  atomic_store(&ReadPos, Read, memory_order_release);
+}
+
+atomic_uint64_t::Type BufferQueue::waitForOpenRing(atomic_uint64_t *P) {
+  // The ring would never be re-opened if this was called from the callback
+  // given to apply.
+  CHECK_NE(atomic_load_relaxed(&ApplyingThread), GetTid());
+  atomic_uint64_t::Type Pos;
+  while ((Pos = atomic_load(P, memory_order_acquire)) & kRingClosed)
+    internal_sched_yield();
+  return Pos;
+}
+
 BufferQueue::ErrorCode BufferQueue::init(size_t BS, size_t BC) {
   SpinMutexLock Guard(&Mutex);
 
   if (!finalizing())
     return BufferQueue::ErrorCode::AlreadyInitialized;
 
-  cleanupBuffers();
-
+  // Allocate everything up front, so that failing leaves the current
+  // generation untouched.
   bool Success = false;
-  BufferSize = BS;
-  BufferCount = BC;
-
-  BackingStore = allocControlBlock(BufferSize, BufferCount);
-  if (BackingStore == nullptr)
+  auto NewBackingStore = allocControlBlock(BS, BC);
+  if (NewBackingStore == nullptr)
     return BufferQueue::ErrorCode::NotEnoughMemory;
 
-  auto CleanupBackingStore = at_scope_exit([&, this] {
-    if (Success)
-      return;
-    deallocControlBlock(BackingStore, BufferSize, BufferCount);
-    BackingStore = nullptr;
+  auto CleanupBackingStore = at_scope_exit([&] {
+    if (!Success)
+      deallocControlBlock(NewBackingStore, BS, BC);
   });
 
   // Initialize enough atomic_uint64_t instances, each
-  ExtentsBackingStore = allocControlBlock(kExtentsSize, BufferCount);
-  if (ExtentsBackingStore == nullptr)
+  auto NewExtentsBackingStore = allocControlBlock(kExtentsSize, BC);
+  if (NewExtentsBackingStore == nullptr)
     return BufferQueue::ErrorCode::NotEnoughMemory;
 
-  auto CleanupExtentsBackingStore = at_scope_exit([&, this] {
-    if (Success)
-      return;
-    deallocControlBlock(ExtentsBackingStore, kExtentsSize, BufferCount);
-    ExtentsBackingStore = nullptr;
+  auto CleanupExtentsBackingStore = at_scope_exit([&] {
+    if (!Success)
+      deallocControlBlock(NewExtentsBackingStore, kExtentsSize, BC);
   });
 
-  Buffers = initArray<BufferRep>(BufferCount);
-  if (Buffers == nullptr)
+  Ring *OldRing = currentRing();
+  Ring *NewRing =
+      OldRing != nullptr && OldRing->Capacity >= BC ? OldRing : allocRing(BC);
+  if (NewRing == nullptr)
     return BufferQueue::ErrorCode::NotEnoughMemory;
+  Success = true;
+
+  // Buffers released from now on belong to the previous generation, and must
+  // not be put back in the ring we are about to replace.
+  atomic_uint64_t::Type Read, Write;
+  closeRing(Read, Write);
+  cleanupBuffers();
+  if (NewRing != OldRing && OldRing != nullptr) {
+    OldRing->Retired = RetiredRings;
+    RetiredRings = OldRing;
+  }
+
+  BufferSize = BS;
+  BufferCount = BC;
+  BackingStore = NewBackingStore;
+  ExtentsBackingStore = NewExtentsBackingStore;
+  Buffers = NewRing->slots();
 
   // At this point we increment the generation number to associate the buffers
   // to the new generation.
@@ -115,6 +189,10 @@ BufferQueue::ErrorCode BufferQueue::init(size_t BS, size_t BC) {
   atomic_store(&BackingStore->RefCount, 1, memory_order_release);
   atomic_store(&ExtentsBackingStore->RefCount, 1, memory_order_release);
 
+  // The positions carry on past the ones of the previous generation, so that a
+  // claim based on one of those can never succeed.
+  auto Base = Write + 1;
+
   // Then we initialise the individual buffers that sub-divide the whole backing
   // store. Each buffer will start at the `Data` member of the ControlBlock, and
   // will be offsets from these locations.
@@ -132,13 +210,16 @@ BufferQueue::ErrorCode BufferQueue::init(size_t BS, size_t BC) {
     Buf.ExtentsBackingStore = ExtentsBackingStore;
     Buf.Count = BufferCount;
     T.Used = false;
+    // All the buffers are in the ring, to be handed out in order.
+    auto Pos = Base + (i + BufferCount - Base % BufferCount) % BufferCount;
+    atomic_store(&T.Sequence, 2 * Pos + 1, memory_order_relaxed);
   }
 
-  Next = Buffers;
-  First = Buffers;
-  LiveBuffers = 0;
+  atomic_store(&NewRing->Count, BufferCount, memory_order_relaxed);
+  atomic_store(&CurrentRing, reinterpret_cast<uptr>(NewRing),
+               memory_order_release);
+  openRing(Base, Base + BufferCount);
   atomic_store(&Finalizing, 0, memory_order_release);
-  Success = true;
   return BufferQueue::ErrorCode::Ok;
 }
 
@@ -151,10 +232,12 @@ BufferQueue::BufferQueue(size_t B, size_t N,
       BackingStore(nullptr),
       ExtentsBackingStore(nullptr),
       Buffers(nullptr),
-      Next(Buffers),
-      First(Buffers),
-      LiveBuffers(0),
-      Generation{0} {
+      Generation{0},
+      CurrentRing{0},
+      RetiredRings(nullptr),
+      ApplyingThread{0},
+      ReadPos{0},
+      WritePos{0} {
   Success = init(B, N) == BufferQueue::ErrorCode::Ok;
 }
 
@@ -162,15 +245,38 @@ BufferQueue::ErrorCode BufferQueue::getBuffer(Buffer &Buf) {
   if (atomic_load(&Finalizing, memory_order_acquire))
     return ErrorCode::QueueFinalizing;
 
+  // Claim the slot at the read position once it holds a buffer. If it does
+  // not, either all the buffers have been handed out, or the buffer released
+  // into it is still being written.
   BufferRep *B = nullptr;
-  {
-    SpinMutexLock Guard(&Mutex);
-    if (LiveBuffers == BufferCount)
+  atomic_uint64_t::Type Count = 0;
+  atomic_uint64_t::Type Pos = atomic_load(&ReadPos, memory_order_acquire);
+  while (true) {
+    if (UNLIKELY(Pos & kRingClosed)) {
+      if (finalizing())
+        return ErrorCode::QueueFinalizing;
+      Pos = waitForOpenRing(&ReadPos);
+      continue;
+    }
+    Ring *R = currentRing();
+    Count = R == nullptr ? 0 : atomic_load_relaxed(&R->Count);
+    if (Count == 0)
+      return ErrorCode::NotEnoughMemory;
+    B = &R->slots()[Pos % Count];
+    auto Diff = static_cast<int64_t>(
+        atomic_load(&B->Sequence, memory_order_acquire) - (2 * Pos + 1));
+    if (Diff == 0) {
+      if (atomic_compare_exchange_weak(&ReadPos, &Pos, Pos + 1,
+                                       memory_order_acquire))
+        break;
+    } else if (Diff < 0 &&
+               atomic_load(&WritePos, memory_order_acquire) <= Pos) {
       return ErrorCode::NotEnoughMemory;
-    B = Next++;
-    if (Next == (Buffers + BufferCount))
-      Next = Buffers;
-    ++LiveBuffers;
+    } else {
+      if (Diff < 0)
+        proc_yield(1);
+      Pos = atomic_load(&ReadPos, memory_order_acquire);
+    }
   }
 
   incRefCount(BackingStore);
@@ -178,30 +284,72 @@ BufferQueue::ErrorCode BufferQueue::getBuffer(Buffer &Buf) {
   Buf = B->Buff;
   Buf.Generation = generation();
   B->Used = true;
+  // The slot can now take a released buffer, once the write position wraps
+  // around to it.
+  atomic_store(&B->Sequence, 2 * (Pos + Count), memory_order_release);
   return ErrorCode::Ok;
 }
 
 BufferQueue::ErrorCode BufferQueue::releaseBuffer(Buffer &Buf) {
-  // Check whether the buffer being referred to is within the bounds of the
-  // backing store's range.
+  // Claim the slot at the write position once it is free. If it is not, either
+  // no buffer has been handed out, which we treat like a buffer from another
+  // generation, or the buffer in it is still being read.
   BufferRep *B = nullptr;
-  {
-    SpinMutexLock Guard(&Mutex);
-    if (Buf.Generation != generation() || LiveBuffers == 0) {
+  atomic_uint64_t::Type Pos = atomic_load(&WritePos, memory_order_acquire);
+  while (true) {
+    if (UNLIKELY(Pos & kRingClosed)) {
+      Pos = waitForOpenRing(&WritePos);
+      continue;
+    }
+    if (Buf.Generation != generation()) {
       Buf = {};
       decRefCount(Buf.BackingStore, Buf.Size, Buf.Count);
       decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
       return BufferQueue::ErrorCode::Ok;
     }
 
-    if (Buf.Data < &BackingStore->Data ||
-        Buf.Data > &BackingStore->Data + (BufferCount * BufferSize))
-      return BufferQueue::ErrorCode::UnrecognizedBuffer;
+    // Check whether the buffer being referred to is within the bounds of the
+    // backing store's range. Those only change while the ring is closed, so
+    // the position tells whether we looked at them in the middle of init.
+    if (BackingStore == nullptr || Buf.Data < &BackingStore->Data ||
+        Buf.Data > &BackingStore->Data + (BufferCount * BufferSize)) {
+      atomic_thread_fence(memory_order_acquire);
+      auto Current = atomic_load(&WritePos, memory_order_acquire);
+      if (Current == Pos)
+        return BufferQueue::ErrorCode::UnrecognizedBuffer;
+      Pos = Current;
+      continue;
+    }
 
-    --LiveBuffers;
-    B = First++;
-    if (First == (Buffers + BufferCount))
-      First = Buffers;
+    Ring *R = currentRing();
+    atomic_uint64_t::Type Count =
+        R == nullptr ? 0 : atomic_load_relaxed(&R->Count);
+    if (Count == 0) {
+      Buf = {};
+      decRefCount(Buf.BackingStore, Buf.Size, Buf.Count);
+      decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
+      return BufferQueue::ErrorCode::Ok;
+    }
+    B = &R->slots()[Pos % Count];
+    auto Diff = static_cast<int64_t>(
+        atomic_load(&B->Sequence, memory_order_acquire) - 2 * Pos);
+    if (Diff == 0) {
+      if (atomic_compare_exchange_weak(&WritePos, &Pos, Pos + 1,
+                                       memory_order_acquire))
+        break;
+    } else if (Diff < 0 &&
+               static_cast<int64_t>(
+                   Pos - atomic_load(&ReadPos, memory_order_acquire)) >=
+                   static_cast<int64_t>(Count)) {
+      Buf = {};
+      decRefCount(Buf.BackingStore, Buf.Size, Buf.Count);
+      decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
+      return BufferQueue::ErrorCode::Ok;
+    } else {
+      if (Diff < 0)
+        proc_yield(1);
+      Pos = atomic_load(&WritePos, memory_order_acquire);
+    }
   }
 
   // Now that the buffer has been released, we mark it as "used".
@@ -211,6 +359,8 @@ BufferQueue::ErrorCode BufferQueue::releaseBuffer(Buffer &Buf) {
   decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
   atomic_store(B->Buff.Extents, atomic_load(Buf.Extents, memory_order_acquire),
                memory_order_release);
+  // Hand the slot over to getBuffer.
+  atomic_store(&B->Sequence, 2 * Pos + 1, memory_order_release);
   Buf = {};
   return ErrorCode::Ok;
 }
@@ -222,16 +372,20 @@ BufferQueue::ErrorCode BufferQueue::finalize() {
 }
 
 void BufferQueue::cleanupBuffers() {
-  for (auto B = Buffers, E = Buffers + BufferCount; B != E; ++B)
-    B->~BufferRep();
-  deallocateBuffer(Buffers, BufferCount);
   decRefCount(BackingStore, BufferSize, BufferCount);
   decRefCount(ExtentsBackingStore, kExtentsSize, BufferCount);
   BackingStore = nullptr;
   ExtentsBackingStore = nullptr;
-  Buffers = nullptr;
   BufferCount = 0;
   BufferSize = 0;
 }
 
-BufferQueue::~BufferQueue() { cleanupBuffers(); }
+BufferQueue::~BufferQueue() {
+  cleanupBuffers();
+  deallocRing(currentRing());
+  while (RetiredRings != nullptr) {
+    auto R = RetiredRings;
+    RetiredRings = R->Retired;
+    deallocRing(R);
+  }
+}
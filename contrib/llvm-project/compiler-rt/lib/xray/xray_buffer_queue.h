@@ -28,6 +28,13 @@ namespace __xray {
 /// get from or return buffers to the queue. This is one key component of the
 /// "flight data recorder" (FDR) mode to support ongoing XRay function call
 /// trace collection.
+///
+/// Getting and returning buffers does not take a lock: the queue is a bounded
+/// multi-producer multi-consumer ring, where every slot carries a sequence
+/// number telling whether it holds a buffer to be handed out at a given
+/// position. Only re-initialising the queue and iterating over the buffers
+/// (through `apply`) close the ring, which makes claims fail until it is open
+/// again, and wait for the slots claimed before that to be handed over.
 class BufferQueue {
 public:
   /// ControlBlock represents the memory layout of how we interpret the backing
@@ -71,6 +78,11 @@ class BufferQueue {
     // This is true if the buffer has been returned to the available queue, and
     // is considered "used" by another thread.
     bool Used = false;
+
+    // Twice the position of the ring at which this slot can next be written
+    // to, or twice the position at which it can next be read from plus one
+    // when it holds a buffer.
+    atomic_uint64_t Sequence;
   };
 
 private:
@@ -146,26 +158,63 @@ class BufferQueue {
   // The collocated ControlBlock and extents storage.
   ControlBlock *ExtentsBackingStore;
 
-  // A dynamically allocated array of BufferRep instances.
-  BufferRep *Buffers;
-
-  // Pointer to the next buffer to be handed out.
-  BufferRep *Next;
+  // The slots of a ring, followed in memory by Capacity BufferRep instances.
+  // getBuffer and releaseBuffer may read the slots of a ring init has moved
+  // on from until their claim fails, so a Ring is only reused for at most
+  // Capacity buffers, and is otherwise retired until the queue is destroyed.
+  struct Ring {
+    size_t Capacity;
+    atomic_uint64_t Count;
+    Ring *Retired;
 
-  // Pointer to the entry in the array where the next released buffer will be
-  // placed.
-  BufferRep *First;
+    BufferRep *slots() { return reinterpret_cast<BufferRep *>(this + 1); }
+  };
 
-  // Count of buffers that have been handed out through 'getBuffer'.
-  size_t LiveBuffers;
+  // The slots of the current ring, as used through the iterators.
+  BufferRep *Buffers;
 
   // We use a generation number to identify buffers and which generation they're
   // associated with.
   atomic_uint64_t Generation;
 
+  // The Ring that Buffers belongs to, read by getBuffer and releaseBuffer.
+  atomic_uintptr_t CurrentRing;
+
+  // Rings replaced by larger ones.
+  Ring *RetiredRings;
+
+  // The thread running the callback given to `apply`, if any.
+  atomic_uint64_t ApplyingThread;
+
+  // Position of the next buffer to be handed out. The positions only ever
+  // increase, and map to the entry at their value modulo BufferCount.
+  char Pad0[kCacheLineSize];
+  atomic_uint64_t ReadPos;
+
+  // Position of the entry where the next released buffer will be placed.
+  char Pad1[kCacheLineSize - sizeof(atomic_uint64_t)];
+  atomic_uint64_t WritePos;
+  char Pad2[kCacheLineSize - sizeof(atomic_uint64_t)];
+
   /// Releases references to the buffers backed by the current buffer queue.
   void cleanupBuffers();
 
+  static Ring *allocRing(size_t Capacity);
+  static void deallocRing(Ring *R);
+
+  Ring *currentRing() const {
+    return reinterpret_cast<Ring *>(
+        atomic_load(&CurrentRing, memory_order_acquire));
+  }
+
+  /// With the mutex held, closes the ring and waits for the slots claimed
+  /// before that to be handed over, returning the positions to re-open it at.
+  void closeRing(atomic_uint64_t::Type &Read, atomic_uint64_t::Type &Write);
+  void openRing(atomic_uint64_t::Type Read, atomic_uint64_t::Type Write);
+
+  /// Waits for the ring to be re-opened, returning the position in |P|.
+  atomic_uint64_t::Type waitForOpenRing(atomic_uint64_t *P);
+
 public:
   enum class ErrorCode : unsigned {
     Ok,
@@ -252,10 +301,18 @@ class BufferQueue {
   /// Applies the provided function F to each Buffer in the queue, only if the
   /// Buffer is marked 'used' (i.e. has been the result of getBuffer(...) and a
   /// releaseBuffer(...) operation).
+  ///
+  /// getBuffer and releaseBuffer wait for `apply` to return, so F must not
+  /// call them on this queue; doing so is reported as a CHECK failure.
   template <class F> void apply(F Fn) XRAY_NEVER_INSTRUMENT {
     SpinMutexLock G(&Mutex);
+    atomic_uint64_t::Type Read, Write;
+    closeRing(Read, Write);
+    atomic_store_relaxed(&ApplyingThread, GetTid());
     for (auto I = begin(), E = end(); I != E; ++I)
       Fn(*I);
+    atomic_store_relaxed(&ApplyingThread, 0);
+    openRing(Read, Write);
   }
 
   using const_iterator = Iterator<const Buffer>;
@@ -464,6 +464,54 @@ class FunctionCallTrie {
 
   const RootArray &getRoots() const XRAY_NEVER_INSTRUMENT { return Roots; }
 
+  // Whether some functions entered have not exited yet, in which case the
+  // nodes on the shadow stack are still referenced.
+  bool hasActiveFunctions() const XRAY_NEVER_INSTRUMENT {
+    return !ShadowStack.empty() || OverflowedFunctions != 0;
+  }
+
+  // Clears the call counts and times of all the nodes, while keeping the nodes
+  // and the shadow stack as they are. Functions still active when this is
+  // called account all of their time when they exit.
+  void resetCounts() XRAY_NEVER_INSTRUMENT {
+    for (auto &N : Nodes) {
+      N.CallCount = 0;
+      N.CumulativeLocalTime = 0;
+    }
+  }
+
+  // A function entered that has not exited yet, as saved by
+  // saveActiveFunctions.
+  struct ActiveFunction {
+    uint64_t EntryTSC;
+    int32_t FId;
+    uint16_t EntryCPU;
+  };
+
+  size_t activeFunctionCount() const XRAY_NEVER_INSTRUMENT {
+    return ShadowStack.size();
+  }
+
+  // Copies the activeFunctionCount() entries of the shadow stack, from the
+  // outermost function, into |Out|, and returns the number of functions that
+  // did not fit in the shadow stack.
+  uint32_t saveActiveFunctions(ActiveFunction *Out) const
+      XRAY_NEVER_INSTRUMENT {
+    for (const auto &E : ShadowStack)
+      *Out++ = {E.EntryTSC, E.NodePtr->FId, E.EntryCPU};
+    return OverflowedFunctions;
+  }
+
+  // Re-enters functions saved from another trie, so that this trie accounts
+  // their exits from the time they were first entered. Only the nodes on their
+  // path are created, with no calls counted yet.
+  void restoreActiveFunctions(const ActiveFunction *Active, size_t N,
+                              uint32_t Overflowed) XRAY_NEVER_INSTRUMENT {
+    for (size_t I = 0; I != N; ++I)
+      enterFunction(Active[I].FId, Active[I].EntryTSC, Active[I].EntryCPU);
+    OverflowedFunctions += Overflowed;
+  }
+
   // The deepCopyInto operation will update the provided FunctionCallTrie by
   // re-creating the contents of this particular FunctionCallTrie in the other
   // FunctionCallTrie. It will do this using a Depth First Traversal from the
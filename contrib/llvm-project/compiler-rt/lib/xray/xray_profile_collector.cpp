@@ -17,6 +17,7 @@
 #include "xray_defs.h"
 #include "xray_profiling_flags.h"
 #include "xray_segmented_array.h"
+#include "xray_utils.h"
 #include <memory>
 #include <pthread.h>
 #include <utility>
@@ -103,6 +104,26 @@ static ProfileBufferArray *ProfileBuffers = nullptr;
 // initialized.
 static atomic_uint8_t CollectorInitialized{0};
 
+// The number of the next block, shared by snapshots and serialize() so that
+// the blocks of a stream are numbered uniquely.
+static atomic_uint32_t NextBlockNum{0};
+
+// A snapshot block waiting to be written out, followed in memory by its Size
+// bytes of data.
+struct SnapshotBlock {
+  SnapshotBlock *Next;
+  size_t Size;
+};
+
+// The snapshot blocks waiting to be written out, in order. SnapshotMutex only
+// guards the queue; the stream is opened on the first write, and written to by
+// whichever thread holds SnapshotWriting.
+SpinMutex SnapshotMutex;
+static SnapshotBlock *SnapshotQueue = nullptr;
+static SnapshotBlock *SnapshotQueueTail = nullptr;
+static atomic_uint8_t SnapshotWriting{0};
+static LogWriter *SnapshotWriter = nullptr;
+
 } // namespace
 
 void post(BufferQueue *Q, FunctionCallTrie &&T,
@@ -227,8 +248,160 @@ static void serializeRecords(ProfileBuffer *Buffer, const BlockHeader &Header,
   DCHECK_EQ(NextPtr - static_cast<uint8_t *>(Buffer->Data), Buffer->Size);
 }
 
+// Go through each record, to compute the sizes.
+//
+// header size = block size (4 bytes)
+//   + block number (4 bytes)
+//   + thread id (8 bytes)
+// record size = path ids (4 bytes * number of ids + sentinel 4 bytes)
+//   + call count (8 bytes)
+//   + local time (8 bytes)
+//   + end of record (8 bytes)
+static u32 recordsSize(const ProfileRecordArray &ProfileRecords)
+    XRAY_NEVER_INSTRUMENT {
+  u32 CumulativeSizes = 0;
+  for (const auto &Record : ProfileRecords)
+    CumulativeSizes += 20 + (4 * Record.Path.size());
+  return CumulativeSizes;
+}
+
+static void deallocSnapshotBlock(SnapshotBlock *B) XRAY_NEVER_INSTRUMENT {
+  deallocateBuffer(reinterpret_cast<uint8_t *>(B),
+                   sizeof(SnapshotBlock) + B->Size);
+}
+
+static SnapshotBlock *takeSnapshotQueue() XRAY_NEVER_INSTRUMENT {
+  SpinMutexLock Lock(&SnapshotMutex);
+  auto Blocks = SnapshotQueue;
+  SnapshotQueue = SnapshotQueueTail = nullptr;
+  return Blocks;
+}
+
+static bool tryLockSnapshotStream() XRAY_NEVER_INSTRUMENT {
+  return !atomic_exchange(&SnapshotWriting, 1, memory_order_acquire);
+}
+
+static void lockSnapshotStream() XRAY_NEVER_INSTRUMENT {
+  while (!tryLockSnapshotStream())
+    internal_sched_yield();
+}
+
+static void unlockSnapshotStream() XRAY_NEVER_INSTRUMENT {
+  atomic_store(&SnapshotWriting, 0, memory_order_release);
+}
+
+// Writes out the queued blocks, with the stream locked but not the queue.
+// Blocks that cannot be written because the stream fails to open are dropped.
+static void writeSnapshotQueue() XRAY_NEVER_INSTRUMENT {
+  while (auto B = takeSnapshotQueue()) {
+    if (SnapshotWriter == nullptr) {
+      SnapshotWriter = LogWriter::Open();
+      if (SnapshotWriter != nullptr) {
+        XRayProfilingFileHeader FileHeader;
+        FileHeader.Timestamp = NanoTime();
+        FileHeader.PID = internal_getpid();
+        auto Begin = reinterpret_cast<const char *>(&FileHeader);
+        SnapshotWriter->WriteAll(Begin, Begin + sizeof(FileHeader));
+      }
+    }
+    while (B != nullptr) {
+      auto Next = B->Next;
+      if (SnapshotWriter != nullptr) {
+        auto Begin = reinterpret_cast<const char *>(B + 1);
+        SnapshotWriter->WriteAll(Begin, Begin + B->Size);
+      }
+      deallocSnapshotBlock(B);
+      B = Next;
+    }
+  }
+}
+
 } // namespace
 
+bool snapshot(const FunctionCallTrie &T, tid_t TId) XRAY_NEVER_INSTRUMENT {
+  if (!atomic_load(&CollectorInitialized, memory_order_acquire))
+    return false;
+  if (T.getRoots().empty())
+    return true;
+
+  // Serialize the block with no lock held, on arenas of our own.
+  auto MaxSize = profilingFlags()->global_allocator_max;
+  auto RecordArena = allocateBuffer(MaxSize);
+  if (RecordArena == nullptr)
+    return false;
+
+  auto RecordArenaCleanup = at_scope_exit(
+      [&]() XRAY_NEVER_INSTRUMENT { deallocateBuffer(RecordArena, MaxSize); });
+
+  auto PathArena = allocateBuffer(MaxSize);
+  if (PathArena == nullptr)
+    return false;
+
+  auto PathArenaCleanup = at_scope_exit(
+      [&]() XRAY_NEVER_INSTRUMENT { deallocateBuffer(PathArena, MaxSize); });
+
+  using ProfileRecordAllocator = typename ProfileRecordArray::AllocatorType;
+  ProfileRecordAllocator PRAlloc(RecordArena, MaxSize);
+  ProfileRecord::PathAllocator PathAlloc(PathArena, MaxSize);
+  ProfileRecordArray ProfileRecords(PRAlloc);
+  populateRecords(ProfileRecords, PathAlloc, T);
+  if (ProfileRecords.empty())
+    return true;
+
+  u32 CumulativeSizes = recordsSize(ProfileRecords);
+  BlockHeader Header{16 + CumulativeSizes,
+                     atomic_fetch_add(&NextBlockNum, 1, memory_order_relaxed),
+                     TId};
+  ProfileBuffer B;
+  B.Size = sizeof(Header) + CumulativeSizes;
+  auto Block = reinterpret_cast<SnapshotBlock *>(
+      allocateBuffer(sizeof(SnapshotBlock) + B.Size));
+  if (Block == nullptr)
+    return false;
+  Block->Next = nullptr;
+  Block->Size = B.Size;
+  B.Data = Block + 1;
+  serializeRecords(&B, Header, ProfileRecords);
+
+  {
+    SpinMutexLock Lock(&SnapshotMutex);
+    if (SnapshotQueueTail != nullptr)
+      SnapshotQueueTail->Next = Block;
+    else
+      SnapshotQueue = Block;
+    SnapshotQueueTail = Block;
+  }
+
+  // Write out the queue, unless another thread already is. Whichever thread
+  // writes looks at the queue again after unlocking the stream, so that blocks
+  // queued while it was writing are not left behind.
+  while (tryLockSnapshotStream()) {
+    writeSnapshotQueue();
+    unlockSnapshotStream();
+    SpinMutexLock Lock(&SnapshotMutex);
+    if (SnapshotQueue == nullptr)
+      break;
+  }
+  return true;
+}
+
+bool flushToSnapshotStream() XRAY_NEVER_INSTRUMENT {
+  lockSnapshotStream();
+  auto UnlockStream =
+      at_scope_exit([]() XRAY_NEVER_INSTRUMENT { unlockSnapshotStream(); });
+  writeSnapshotQueue();
+  if (SnapshotWriter == nullptr)
+    return false;
+
+  SpinMutexLock Lock(&GlobalMutex);
+  if (ProfileBuffers != nullptr)
+    for (const auto &B : *ProfileBuffers) {
+      auto Begin = static_cast<const char *>(B.Data);
+      SnapshotWriter->WriteAll(Begin, Begin + B.Size);
+    }
+  return true;
+}
+
 void serialize() XRAY_NEVER_INSTRUMENT {
   if (!atomic_load(&CollectorInitialized, memory_order_acquire))
     return;
@@ -245,7 +418,6 @@ void serialize() XRAY_NEVER_INSTRUMENT {
     return;
 
   // Then repopulate the global ProfileBuffers.
-  u32 I = 0;
   auto MaxSize = profilingFlags()->global_allocator_max;
   auto ProfileArena = allocateBuffer(MaxSize);
   if (ProfileArena == nullptr)
@@ -280,20 +452,11 @@ void serialize() XRAY_NEVER_INSTRUMENT {
     DCHECK(!ThreadTrie.FCT.getRoots().empty());
     DCHECK(!ProfileRecords.empty());
 
-    // Go through each record, to compute the sizes.
-    //
-    // header size = block size (4 bytes)
-    //   + block number (4 bytes)
-    //   + thread id (8 bytes)
-    // record size = path ids (4 bytes * number of ids + sentinel 4 bytes)
-    //   + call count (8 bytes)
-    //   + local time (8 bytes)
-    //   + end of record (8 bytes)
-    u32 CumulativeSizes = 0;
-    for (const auto &Record : ProfileRecords)
-      CumulativeSizes += 20 + (4 * Record.Path.size());
-
-    BlockHeader Header{16 + CumulativeSizes, I++, ThreadTrie.TId};
+    u32 CumulativeSizes = recordsSize(ProfileRecords);
+
+    BlockHeader Header{16 + CumulativeSizes,
+                       atomic_fetch_add(&NextBlockNum, 1, memory_order_relaxed),
+                       ThreadTrie.TId};
     auto B = ProfileBuffers->Append({});
     B->Size = sizeof(Header) + CumulativeSizes;
     B->Data = allocateBuffer(B->Size);
@@ -304,6 +467,21 @@ void serialize() XRAY_NEVER_INSTRUMENT {
 
 void reset() XRAY_NEVER_INSTRUMENT {
   atomic_store(&CollectorInitialized, 0, memory_order_release);
+  {
+    lockSnapshotStream();
+    for (auto B = takeSnapshotQueue(); B != nullptr;) {
+      auto Next = B->Next;
+      deallocSnapshotBlock(B);
+      B = Next;
+    }
+    if (SnapshotWriter != nullptr) {
+      LogWriter::Close(SnapshotWriter);
+      SnapshotWriter = nullptr;
+    }
+    unlockSnapshotStream();
+    atomic_store(&NextBlockNum, 0, memory_order_relaxed);
+  }
+
   SpinMutexLock Lock(&GlobalMutex);
 
   if (ProfileBuffers != nullptr) {
@@ -57,6 +57,25 @@ void post(BufferQueue *Q, FunctionCallTrie &&T,
 ///
 void serialize();
 
+/// Serializes the FunctionCallTrie of a thread into a block, in the format
+/// described above, and appends it to the snapshot stream. The stream is a
+/// profile file opened on the first snapshot, starting with the usual file
+/// header. The blocks of a thread hold the counts since its previous snapshot,
+/// so that adding up the blocks of the stream gives the whole profile.
+///
+/// This is meant to be called by the thread owning the trie, which must not
+/// be modified while it is being serialized. The block is serialized without
+/// holding any lock and queued; the queue is written out by one thread at a
+/// time, while the others return as soon as their block is queued. Returns
+/// false if the block could not be serialized.
+bool snapshot(const FunctionCallTrie &T, tid_t TId);
+
+/// Writes out the queued snapshots, then appends the blocks produced by
+/// `serialize` to the snapshot stream, if any snapshot has been written.
+/// Returns false otherwise, in which case the profile is to be written to a
+/// file of its own.
+bool flushToSnapshotStream();
+
 /// The reset function will clear out any internal memory held by the
 /// service. The intent is to have the resetting be done in calls to the
 /// initialization routine, or explicitly through the flush log API.
@@ -18,6 +18,7 @@
 #include "sanitizer_common/sanitizer_flags.h"
 #include "xray/xray_interface.h"
 #include "xray/xray_log_interface.h"
+#include "xray_allocator.h"
 #include "xray_buffer_queue.h"
 #include "xray_flags.h"
 #include "xray_profile_collector.h"
@@ -71,6 +72,11 @@ thread_local atomic_uint8_t TLDInitGuard{0};
 // non-essential work should be ignored (things like recording events, etc.).
 thread_local atomic_uint8_t ThreadExitingLatch{0};
 
+// The snapshot_interval_ms flag in TSC ticks, or 0 if snapshots are disabled,
+// and the TSC from which the current thread takes its next snapshot.
+static uint64_t SnapshotIntervalTicks = 0;
+thread_local uint64_t NextSnapshotTSC = 0;
+
 static ProfilingData *getThreadLocalData() XRAY_NEVER_INSTRUMENT {
   thread_local auto ThreadOnce = []() XRAY_NEVER_INSTRUMENT {
     pthread_setspecific(ProfilingKey, &TLD);
@@ -194,6 +200,45 @@ static void postCurrentThreadFCT(ProfilingData &T) XRAY_NEVER_INSTRUMENT {
   ThreadBuffers = FunctionCallTrie::Allocators::Buffers{};
 }
 
+// Appends a snapshot of the trie of the current thread to the profile, then
+// rebuilds the trie on the same buffers, which recycles all of its nodes. The
+// functions still active are entered again into the new trie, so that only
+// the nodes on their path are kept.
+static void snapshotCurrentThreadFCT(ProfilingData &T,
+                                     uint64_t TSC) XRAY_NEVER_INSTRUMENT {
+  bool FirstCall = NextSnapshotTSC == 0;
+  NextSnapshotTSC = TSC + SnapshotIntervalTicks;
+  if (FirstCall)
+    return;
+
+  auto FCT = reinterpret_cast<FunctionCallTrie *>(atomic_load_relaxed(&T.FCT));
+  if (!profileCollectorService::snapshot(*FCT, GetTid()))
+    return;
+
+  auto Depth = FCT->activeFunctionCount();
+  FunctionCallTrie::ActiveFunction *Active = nullptr;
+  if (Depth != 0) {
+    Active = allocateBuffer<FunctionCallTrie::ActiveFunction>(Depth);
+    if (Active == nullptr) {
+      // Keep the nodes, so that at least the counts do not add up twice.
+      FCT->resetCounts();
+      return;
+    }
+  }
+  auto Overflowed = FCT->saveActiveFunctions(Active);
+
+  auto Allocators = reinterpret_cast<FunctionCallTrie::Allocators *>(
+      atomic_load_relaxed(&T.Allocators));
+  FCT->~FunctionCallTrie();
+  Allocators->~Allocators();
+  new (Allocators) FunctionCallTrie::Allocators(
+      FunctionCallTrie::InitAllocatorsFromBuffers(ThreadBuffers));
+  new (FCT) FunctionCallTrie(*Allocators);
+
+  FCT->restoreActiveFunctions(Active, Depth, Overflowed);
+  deallocateBuffer(Active, Depth);
+}
+
 } // namespace
 
 const char *profilingCompilerDefinedFlags() XRAY_NEVER_INSTRUMENT {
@@ -240,6 +285,10 @@ XRayLogFlushStatus profilingFlush() XRAY_NEVER_INSTRUMENT {
     if (B.Data == nullptr) {
       if (Verbosity())
         Report("profiling: No data to flush.\n");
+    } else if (profileCollectorService::flushToSnapshotStream()) {
+      // The profile follows the snapshots taken while profiling was running.
+      if (Verbosity())
+        Report("profiling: Appended profile to the snapshot file.\n");
     } else {
       LogWriter *LW = LogWriter::Open();
       if (LW == nullptr) {
@@ -300,6 +349,8 @@ void profilingHandleArg0(int32_t FuncId,
   case XRayEntryType::EXIT:
   case XRayEntryType::TAIL:
     FCT->exitFunction(FuncId, TSC, CPU);
+    if (UNLIKELY(SnapshotIntervalTicks != 0 && TSC >= NextSnapshotTSC))
+      snapshotCurrentThreadFCT(*T, TSC);
     break;
   default:
     // FIXME: Handle bugs.
@@ -384,6 +435,11 @@ profilingLoggingInit(size_t, size_t, void *Options,
     *profilingFlags() = Flags;
   }
 
+  SnapshotIntervalTicks =
+      profilingFlags()->snapshot_interval_ms > 0
+          ? profilingFlags()->snapshot_interval_ms * (getTSCFrequency() / 1000)
+          : 0;
+
   // We need to reset the profile data collection implementation now.
   profileCollectorService::reset();
 
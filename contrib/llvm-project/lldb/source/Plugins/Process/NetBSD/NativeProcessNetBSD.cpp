@@ -17,6 +17,8 @@
 #include "lldb/Utility/State.h"
 #include "llvm/Support/Errno.h"
 
+#include <algorithm>
+
 // System includes - They have to be included after framework includes because
 // they define some macros which collide with variable names in other modules
 // clang-format off
@@ -489,6 +491,10 @@ Status NativeProcessNetBSD::Resume(const ResumeActionList &resume_actions) {
     signal = siginfo->psi_siginfo.si_signo;
   }
 
+  // The inferior may map or unmap memory while running, the memory region
+  // cache is read again at the next stop.
+  m_mem_region_cache.clear();
+
   ret = PtraceWrapper(PT_CONTINUE, GetID(), reinterpret_cast<void *>(1),
                       signal);
   if (ret.Success())
@@ -575,36 +581,33 @@ Status NativeProcessNetBSD::GetMemoryRegionInfo(lldb::addr_t load_addr,
     return error;
   }
 
-  lldb::addr_t prev_base_address = 0;
-  // FIXME start by finding the last region that is <= target address using
-  // binary search.  Data is sorted.
+  // The cache is sorted by base address: find the first region that starts
+  // after the target address, the one before it may contain the address.
   // There can be a ton of regions on pthreads apps with lots of threads.
-  for (auto it = m_mem_region_cache.begin(); it != m_mem_region_cache.end();
-       ++it) {
-    MemoryRegionInfo &proc_entry_info = it->first;
-    // Sanity check assumption that memory map entries are ascending.
-    assert((proc_entry_info.GetRange().GetRangeBase() >= prev_base_address) &&
-           "descending memory map entries detected, unexpected");
-    prev_base_address = proc_entry_info.GetRange().GetRangeBase();
-    UNUSED_IF_ASSERT_DISABLED(prev_base_address);
-    // If the target address comes before this entry, indicate distance to next
+  auto it = std::upper_bound(
+      m_mem_region_cache.begin(), m_mem_region_cache.end(), load_addr,
+      [](lldb::addr_t addr,
+         const std::pair<MemoryRegionInfo, FileSpec> &entry) {
+        return addr < entry.first.GetRange().GetRangeBase();
+      });
+  if (it != m_mem_region_cache.begin() &&
+      std::prev(it)->first.GetRange().Contains(load_addr)) {
+    // The target address is within the memory region before it.
+    range_info = std::prev(it)->first;
+    return error;
+  }
+  if (it != m_mem_region_cache.end()) {
+    // The target address comes before this entry, indicate distance to next
     // region.
-    if (load_addr < proc_entry_info.GetRange().GetRangeBase()) {
-      range_info.GetRange().SetRangeBase(load_addr);
-      range_info.GetRange().SetByteSize(
-          proc_entry_info.GetRange().GetRangeBase() - load_addr);
-      range_info.SetReadable(MemoryRegionInfo::OptionalBool::eNo);
-      range_info.SetWritable(MemoryRegionInfo::OptionalBool::eNo);
-      range_info.SetExecutable(MemoryRegionInfo::OptionalBool::eNo);
-      range_info.SetMapped(MemoryRegionInfo::OptionalBool::eNo);
-      return error;
-    } else if (proc_entry_info.GetRange().Contains(load_addr)) {
-      // The target address is within the memory region we're processing here.
-      range_info = proc_entry_info;
-      return error;
-    }
-    // The target memory address comes somewhere after the region we just
-    // parsed.
+    const MemoryRegionInfo &proc_entry_info = it->first;
+    range_info.GetRange().SetRangeBase(load_addr);
+    range_info.GetRange().SetByteSize(
+        proc_entry_info.GetRange().GetRangeBase() - load_addr);
+    range_info.SetReadable(MemoryRegionInfo::OptionalBool::eNo);
+    range_info.SetWritable(MemoryRegionInfo::OptionalBool::eNo);
+    range_info.SetExecutable(MemoryRegionInfo::OptionalBool::eNo);
+    range_info.SetMapped(MemoryRegionInfo::OptionalBool::eNo);
+    return error;
   }
   // If we made it here, we didn't find an entry that contained the given
   // address. Return the load_addr as start and the amount of bytes betwwen
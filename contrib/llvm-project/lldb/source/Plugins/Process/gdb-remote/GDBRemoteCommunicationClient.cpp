@@ -83,6 +83,7 @@ GDBRemoteCommunicationClient::GDBRemoteCommunicationClient()
       m_supports_qXfer_libraries_svr4_read(eLazyBoolCalculate),
       m_supports_qXfer_features_read(eLazyBoolCalculate),
       m_supports_qXfer_memory_map_read(eLazyBoolCalculate),
+      m_supports_qXfer_memory_regions_read(eLazyBoolCalculate),
       m_supports_augmented_libraries_svr4_read(eLazyBoolCalculate),
       m_supports_jThreadExtendedInfo(eLazyBoolCalculate),
       m_supports_jLoadedDynamicLibrariesInfos(eLazyBoolCalculate),
@@ -199,6 +200,13 @@ bool GDBRemoteCommunicationClient::GetQXferMemoryMapReadSupported() {
   return m_supports_qXfer_memory_map_read == eLazyBoolYes;
 }
 
+bool GDBRemoteCommunicationClient::GetQXferMemoryRegionsReadSupported() {
+  if (m_supports_qXfer_memory_regions_read == eLazyBoolCalculate) {
+    GetRemoteQSupported();
+  }
+  return m_supports_qXfer_memory_regions_read == eLazyBoolYes;
+}
+
 uint64_t GDBRemoteCommunicationClient::GetRemoteMaxPacketSize() {
   if (m_max_packet_size == 0) {
     GetRemoteQSupported();
@@ -297,6 +305,7 @@ void GDBRemoteCommunicationClient::ResetDiscoverableSettings(bool did_exec) {
     m_supports_qXfer_libraries_svr4_read = eLazyBoolCalculate;
     m_supports_qXfer_features_read = eLazyBoolCalculate;
     m_supports_qXfer_memory_map_read = eLazyBoolCalculate;
+    m_supports_qXfer_memory_regions_read = eLazyBoolCalculate;
     m_supports_augmented_libraries_svr4_read = eLazyBoolCalculate;
     m_supports_qProcessInfoPID = true;
     m_supports_qfProcessInfo = true;
@@ -342,6 +351,7 @@ void GDBRemoteCommunicationClient::GetRemoteQSupported() {
   m_supports_augmented_libraries_svr4_read = eLazyBoolNo;
   m_supports_qXfer_features_read = eLazyBoolNo;
   m_supports_qXfer_memory_map_read = eLazyBoolNo;
+  m_supports_qXfer_memory_regions_read = eLazyBoolNo;
   m_max_packet_size = UINT64_MAX; // It's supposed to always be there, but if
                                   // not, we assume no limit
 
@@ -378,6 +388,8 @@ void GDBRemoteCommunicationClient::GetRemoteQSupported() {
       m_supports_qXfer_features_read = eLazyBoolYes;
     if (::strstr(response_cstr, "qXfer:memory-map:read+"))
       m_supports_qXfer_memory_map_read = eLazyBoolYes;
+    if (::strstr(response_cstr, "qXfer:lldb-memory-regions:read+"))
+      m_supports_qXfer_memory_regions_read = eLazyBoolYes;
 
     // Look for a list of compressions in the features list e.g.
     // qXfer:features:read+;PacketSize=20000;qEcho+;SupportedCompressions=zlib-
@@ -1468,6 +1480,65 @@ Status GDBRemoteCommunicationClient::Detach(bool keep_stopped) {
   return error;
 }
 
+// Parses the "start:...;size:...;" description of a region, as sent in the
+// qMemoryRegionInfo reply and the lldb-memory-regions xfer object. A region
+// without permissions is unmapped. Returns the error the reply carries, if any.
+static Status ParseMemoryRegionInfo(StringExtractorGDBRemote &response,
+                                    MemoryRegionInfo &region_info) {
+  Status error;
+  llvm::StringRef name;
+  llvm::StringRef value;
+  addr_t addr_value = LLDB_INVALID_ADDRESS;
+  bool saw_permissions = false;
+  while (response.GetNameColonValue(name, value)) {
+    if (name.equals("start")) {
+      if (!value.getAsInteger(16, addr_value))
+        region_info.GetRange().SetRangeBase(addr_value);
+    } else if (name.equals("size")) {
+      if (!value.getAsInteger(16, addr_value))
+        region_info.GetRange().SetByteSize(addr_value);
+    } else if (name.equals("permissions") &&
+               region_info.GetRange().IsValid()) {
+      saw_permissions = true;
+      if (value.find('r') != llvm::StringRef::npos)
+        region_info.SetReadable(MemoryRegionInfo::eYes);
+      else
+        region_info.SetReadable(MemoryRegionInfo::eNo);
+
+      if (value.find('w') != llvm::StringRef::npos)
+        region_info.SetWritable(MemoryRegionInfo::eYes);
+      else
+        region_info.SetWritable(MemoryRegionInfo::eNo);
+
+      if (value.find('x') != llvm::StringRef::npos)
+        region_info.SetExecutable(MemoryRegionInfo::eYes);
+      else
+        region_info.SetExecutable(MemoryRegionInfo::eNo);
+
+      region_info.SetMapped(MemoryRegionInfo::eYes);
+    } else if (name.equals("name")) {
+      StringExtractorGDBRemote name_extractor(value);
+      std::string name;
+      name_extractor.GetHexByteString(name);
+      region_info.SetName(name.c_str());
+    } else if (name.equals("error")) {
+      StringExtractorGDBRemote error_extractor(value);
+      std::string error_string;
+      // Now convert the HEX bytes into a string value
+      error_extractor.GetHexByteString(error_string);
+      error.SetErrorString(error_string.c_str());
+    }
+  }
+
+  if (!saw_permissions) {
+    region_info.SetReadable(MemoryRegionInfo::eNo);
+    region_info.SetWritable(MemoryRegionInfo::eNo);
+    region_info.SetExecutable(MemoryRegionInfo::eNo);
+    region_info.SetMapped(MemoryRegionInfo::eNo);
+  }
+  return error;
+}
+
 Status GDBRemoteCommunicationClient::GetMemoryRegionInfo(
     lldb::addr_t addr, lldb_private::MemoryRegionInfo &region_info) {
   Status error;
@@ -1484,64 +1555,12 @@ Status GDBRemoteCommunicationClient::GetMemoryRegionInfo(
     if (SendPacketAndWaitForResponse(packet, response, false) ==
             PacketResult::Success &&
         response.GetResponseType() == StringExtractorGDBRemote::eResponse) {
-      llvm::StringRef name;
-      llvm::StringRef value;
-      addr_t addr_value = LLDB_INVALID_ADDRESS;
-      bool success = true;
-      bool saw_permissions = false;
-      while (success && response.GetNameColonValue(name, value)) {
-        if (name.equals("start")) {
-          if (!value.getAsInteger(16, addr_value))
-            region_info.GetRange().SetRangeBase(addr_value);
-        } else if (name.equals("size")) {
-          if (!value.getAsInteger(16, addr_value))
-            region_info.GetRange().SetByteSize(addr_value);
-        } else if (name.equals("permissions") &&
-                   region_info.GetRange().IsValid()) {
-          saw_permissions = true;
-          if (region_info.GetRange().Contains(addr)) {
-            if (value.find('r') != llvm::StringRef::npos)
-              region_info.SetReadable(MemoryRegionInfo::eYes);
-            else
-              region_info.SetReadable(MemoryRegionInfo::eNo);
-
-            if (value.find('w') != llvm::StringRef::npos)
-              region_info.SetWritable(MemoryRegionInfo::eYes);
-            else
-              region_info.SetWritable(MemoryRegionInfo::eNo);
-
-            if (value.find('x') != llvm::StringRef::npos)
-              region_info.SetExecutable(MemoryRegionInfo::eYes);
-            else
-              region_info.SetExecutable(MemoryRegionInfo::eNo);
-
-            region_info.SetMapped(MemoryRegionInfo::eYes);
-          } else {
-            // The reported region does not contain this address -- we're
-            // looking at an unmapped page
-            region_info.SetReadable(MemoryRegionInfo::eNo);
-            region_info.SetWritable(MemoryRegionInfo::eNo);
-            region_info.SetExecutable(MemoryRegionInfo::eNo);
-            region_info.SetMapped(MemoryRegionInfo::eNo);
-          }
-        } else if (name.equals("name")) {
-          StringExtractorGDBRemote name_extractor(value);
-          std::string name;
-          name_extractor.GetHexByteString(name);
-          region_info.SetName(name.c_str());
-        } else if (name.equals("error")) {
-          StringExtractorGDBRemote error_extractor(value);
-          std::string error_string;
-          // Now convert the HEX bytes into a string value
-          error_extractor.GetHexByteString(error_string);
-          error.SetErrorString(error_string.c_str());
-        }
-      }
+      error = ParseMemoryRegionInfo(response, region_info);
 
       if (region_info.GetRange().IsValid()) {
-        // We got a valid address range back but no permissions -- which means
-        // this is an unmapped page
-        if (!saw_permissions) {
+        if (!region_info.GetRange().Contains(addr)) {
+          // The reported region does not contain this address -- we're
+          // looking at an unmapped page
           region_info.SetReadable(MemoryRegionInfo::eNo);
           region_info.SetWritable(MemoryRegionInfo::eNo);
           region_info.SetExecutable(MemoryRegionInfo::eNo);
@@ -1586,6 +1605,58 @@ Status GDBRemoteCommunicationClient::GetMemoryRegionInfo(
   return error;
 }
 
+Status GDBRemoteCommunicationClient::GetMemoryRegions(
+    std::vector<MemoryRegionInfo> &regions) {
+  Status error;
+  regions.clear();
+
+  if (!GetQXferMemoryRegionsReadSupported()) {
+    error.SetErrorString("qXfer:lldb-memory-regions:read is not supported");
+    return error;
+  }
+
+  std::string data;
+  if (!ReadExtFeature(ConstString("lldb-memory-regions"), ConstString(""),
+                      data, error))
+    return error;
+
+  // One mapped region per line, each in the qMemoryRegionInfo reply format.
+  llvm::SmallVector<llvm::StringRef, 32> lines;
+  llvm::StringRef(data).split(lines, '\n', -1, /*KeepEmpty=*/false);
+  regions.reserve(lines.size());
+  for (llvm::StringRef line : lines) {
+    StringExtractorGDBRemote extractor(line);
+    MemoryRegionInfo region_info;
+    error = ParseMemoryRegionInfo(extractor, region_info);
+    if (error.Fail()) {
+      regions.clear();
+      return error;
+    }
+    if (!region_info.GetRange().IsValid() ||
+        (!regions.empty() && region_info.GetRange().GetRangeBase() <
+                                 regions.back().GetRange().GetRangeEnd())) {
+      regions.clear();
+      error.SetErrorString("Server returned invalid memory region list");
+      return error;
+    }
+    regions.push_back(region_info);
+  }
+  return error;
+}
+
+void GDBRemoteCommunicationClient::AddQXferMemoryMapFlashInfo(
+    MemoryRegionInfo &region_info) {
+  MemoryRegionInfo qXfer_region_info;
+  if (GetQXferMemoryMapRegionInfo(region_info.GetRange().GetRangeBase(),
+                                  qXfer_region_info)
+          .Fail())
+    return;
+  if (region_info.GetRange() == qXfer_region_info.GetRange()) {
+    region_info.SetFlash(qXfer_region_info.GetFlash());
+    region_info.SetBlocksize(qXfer_region_info.GetBlocksize());
+  }
+}
+
 Status GDBRemoteCommunicationClient::GetQXferMemoryMapRegionInfo(
     lldb::addr_t addr, MemoryRegionInfo &region) {
   Status error = LoadQXferMemoryMap();
@@ -232,6 +232,15 @@ class GDBRemoteCommunicationClient : public GDBRemoteClientBase {
 
   Status GetMemoryRegionInfo(lldb::addr_t addr, MemoryRegionInfo &range_info);
 
+  // Reads all the mapped regions of the process, sorted by address, in a
+  // single qXfer:lldb-memory-regions transfer.
+  Status GetMemoryRegions(std::vector<MemoryRegionInfo> &regions);
+
+  // Adds the flash-memory information of the qXfer:memory-map:read region
+  // with the same range as region_info, which the other region queries do not
+  // report.
+  void AddQXferMemoryMapFlashInfo(MemoryRegionInfo &region_info);
+
   Status GetWatchpointSupportInfo(uint32_t &num);
 
   Status GetWatchpointSupportInfo(uint32_t &num, bool &after,
@@ -357,6 +366,8 @@ class GDBRemoteCommunicationClient : public GDBRemoteClientBase {
 
   bool GetQXferMemoryMapReadSupported();
 
+  bool GetQXferMemoryRegionsReadSupported();
+
   LazyBool SupportsAllocDeallocMemory() // const
   {
     // Uncomment this to have lldb pretend the debug server doesn't respond to
@@ -546,6 +557,7 @@ class GDBRemoteCommunicationClient : public GDBRemoteClientBase {
   LazyBool m_supports_qXfer_libraries_svr4_read;
   LazyBool m_supports_qXfer_features_read;
   LazyBool m_supports_qXfer_memory_map_read;
+  LazyBool m_supports_qXfer_memory_regions_read;
   LazyBool m_supports_augmented_libraries_svr4_read;
   LazyBool m_supports_jThreadExtendedInfo;
   LazyBool m_supports_jLoadedDynamicLibrariesInfos;
@@ -847,6 +847,7 @@ GDBRemoteCommunicationServerCommon::Handle_qSupported(
   response.PutCString(";QPassSignals+");
   response.PutCString(";qXfer:auxv:read+");
   response.PutCString(";qXfer:libraries-svr4:read+");
+  response.PutCString(";qXfer:lldb-memory-regions:read+");
 #endif
 
   return SendPacketNoLock(response.GetString());
@@ -2434,6 +2434,40 @@ GDBRemoteCommunicationServerLLGS::Handle_qMemoryRegionInfoSupported(
   return SendOKResponse();
 }
 
+// Writes the "start:...;size:...;" description of a region used by both the
+// qMemoryRegionInfo reply and the lldb-memory-regions xfer object.
+static void AppendMemoryRegionInfo(Stream &response,
+                                   const MemoryRegionInfo &region_info) {
+  // Range start and size.
+  response.Printf("start:%" PRIx64 ";size:%" PRIx64 ";",
+                  region_info.GetRange().GetRangeBase(),
+                  region_info.GetRange().GetByteSize());
+
+  // Permissions.
+  if (region_info.GetReadable() || region_info.GetWritable() ||
+      region_info.GetExecutable()) {
+    // Write permissions info.
+    response.PutCString("permissions:");
+
+    if (region_info.GetReadable())
+      response.PutChar('r');
+    if (region_info.GetWritable())
+      response.PutChar('w');
+    if (region_info.GetExecutable())
+      response.PutChar('x');
+
+    response.PutChar(';');
+  }
+
+  // Name
+  ConstString name = region_info.GetName();
+  if (name) {
+    response.PutCString("name:");
+    response.PutStringAsRawHex8(name.GetStringRef());
+    response.PutChar(';');
+  }
+}
+
 GDBRemoteCommunication::PacketResult
 GDBRemoteCommunicationServerLLGS::Handle_qMemoryRegionInfo(
     StringExtractorGDBRemote &packet) {
@@ -2470,34 +2504,7 @@ GDBRemoteCommunicationServerLLGS::Handle_qMemoryRegionInfo(
     response.PutStringAsRawHex8(error.AsCString());
     response.PutChar(';');
   } else {
-    // Range start and size.
-    response.Printf("start:%" PRIx64 ";size:%" PRIx64 ";",
-                    region_info.GetRange().GetRangeBase(),
-                    region_info.GetRange().GetByteSize());
-
-    // Permissions.
-    if (region_info.GetReadable() || region_info.GetWritable() ||
-        region_info.GetExecutable()) {
-      // Write permissions info.
-      response.PutCString("permissions:");
-
-      if (region_info.GetReadable())
-        response.PutChar('r');
-      if (region_info.GetWritable())
-        response.PutChar('w');
-      if (region_info.GetExecutable())
-        response.PutChar('x');
-
-      response.PutChar(';');
-    }
-
-    // Name
-    ConstString name = region_info.GetName();
-    if (name) {
-      response.PutCString("name:");
-      response.PutStringAsRawHex8(name.GetStringRef());
-      response.PutChar(';');
-    }
+    AppendMemoryRegionInfo(response, region_info);
   }
 
   return SendPacketNoLock(response.GetString());
@@ -2876,6 +2883,32 @@ GDBRemoteCommunicationServerLLGS::ReadXferObject(llvm::StringRef object,
   if (object == "features" && annex == "target.xml")
     return BuildTargetXml();
 
+  if (object == "lldb-memory-regions") {
+    // The mapped regions, one per line, in the qMemoryRegionInfo format. The
+    // unmapped gaps between them are left for the client to compute.
+    StreamString response;
+    lldb::addr_t addr = 0;
+    while (true) {
+      MemoryRegionInfo region_info;
+      Status error =
+          m_debugged_process_up->GetMemoryRegionInfo(addr, region_info);
+      if (error.Fail()) {
+        if (addr == 0)
+          return error.ToError();
+        break;
+      }
+      const lldb::addr_t end = region_info.GetRange().GetRangeEnd();
+      if (region_info.GetMapped() != MemoryRegionInfo::OptionalBool::eNo) {
+        AppendMemoryRegionInfo(response, region_info);
+        response.PutChar('\n');
+      }
+      if (end == LLDB_INVALID_ADDRESS || end <= addr)
+        break;
+      addr = end;
+    }
+    return MemoryBuffer::getMemBufferCopy(response.GetString(), __FUNCTION__);
+  }
+
   return llvm::make_error<PacketUnimplementedError>(
       "Xfer object not supported");
 }
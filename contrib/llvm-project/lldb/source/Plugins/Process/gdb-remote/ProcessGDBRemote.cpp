@@ -262,7 +262,9 @@ ProcessGDBRemote::ProcessGDBRemote(lldb::TargetSP target_sp,
       m_waiting_for_attach(false), m_destroy_tried_resuming(false),
       m_command_sp(), m_breakpoint_pc_offset(0),
       m_initial_tid(LLDB_INVALID_THREAD_ID), m_replay_mode(false),
-      m_allow_flash_writes(false), m_erased_flash_ranges() {
+      m_allow_flash_writes(false), m_erased_flash_ranges(),
+      m_memory_regions(), m_memory_regions_stop_id(UINT32_MAX),
+      m_memory_regions_valid(false) {
   m_async_broadcaster.SetEventName(eBroadcastBitAsyncThreadShouldExit,
                                    "async thread should exit");
   m_async_broadcaster.SetEventName(eBroadcastBitAsyncContinue,
@@ -2952,6 +2954,9 @@ lldb::addr_t ProcessGDBRemote::DoAllocateMemory(size_t size,
       GetLogIfAnyCategoriesSet(LIBLLDB_LOG_PROCESS | LIBLLDB_LOG_EXPRESSIONS));
   addr_t allocated_addr = LLDB_INVALID_ADDRESS;
 
+  // The allocation changes the memory map without a stop.
+  m_memory_regions_stop_id = UINT32_MAX;
+
   if (m_gdb_comm.SupportsAllocDeallocMemory() != eLazyBoolNo) {
     allocated_addr = m_gdb_comm.AllocateMemory(size, permissions);
     if (allocated_addr != LLDB_INVALID_ADDRESS ||
@@ -2993,6 +2998,44 @@ lldb::addr_t ProcessGDBRemote::DoAllocateMemory(size_t size,
 
 Status ProcessGDBRemote::GetMemoryRegionInfo(addr_t load_addr,
                                              MemoryRegionInfo &region_info) {
+  // If the stub can send the whole memory map at once, read it once per stop
+  // and answer from it rather than sending a qMemoryRegionInfo per region.
+  if (m_gdb_comm.GetQXferMemoryRegionsReadSupported() &&
+      GetPrivateState() == eStateStopped) {
+    const uint32_t stop_id = GetStopID();
+    if (m_memory_regions_stop_id != stop_id) {
+      m_memory_regions_valid =
+          m_gdb_comm.GetMemoryRegions(m_memory_regions).Success();
+      m_memory_regions_stop_id = stop_id;
+    }
+    if (m_memory_regions_valid) {
+      auto pos = std::upper_bound(
+          m_memory_regions.begin(), m_memory_regions.end(), load_addr,
+          [](addr_t addr, const MemoryRegionInfo &region) {
+            return addr < region.GetRange().GetRangeBase();
+          });
+      if (pos != m_memory_regions.begin() &&
+          std::prev(pos)->GetRange().Contains(load_addr)) {
+        region_info = *std::prev(pos);
+      } else {
+        // An unmapped range, up to the next mapped region.
+        region_info.Clear();
+        region_info.GetRange().SetRangeBase(load_addr);
+        if (pos != m_memory_regions.end())
+          region_info.GetRange().SetRangeEnd(pos->GetRange().GetRangeBase());
+        else
+          region_info.GetRange().SetRangeEnd(LLDB_INVALID_ADDRESS);
+        region_info.SetReadable(MemoryRegionInfo::eNo);
+        region_info.SetWritable(MemoryRegionInfo::eNo);
+        region_info.SetExecutable(MemoryRegionInfo::eNo);
+        region_info.SetMapped(MemoryRegionInfo::eNo);
+      }
+      // Merge the flash-memory information of qXfer:memory-map:read, as the
+      // qMemoryRegionInfo path does.
+      m_gdb_comm.AddQXferMemoryMapFlashInfo(region_info);
+      return Status();
+    }
+  }
 
   Status error(m_gdb_comm.GetMemoryRegionInfo(load_addr, region_info));
   return error;
@@ -3012,6 +3055,7 @@ Status ProcessGDBRemote::GetWatchpointSupportInfo(uint32_t &num, bool &after) {
 
 Status ProcessGDBRemote::DoDeallocateMemory(lldb::addr_t addr) {
   Status error;
+  m_memory_regions_stop_id = UINT32_MAX;
   LazyBool supported = m_gdb_comm.SupportsAllocDeallocMemory();
 
   switch (supported) {
@@ -291,6 +291,11 @@ class ProcessGDBRemote : public Process,
   using FlashRangeVector = lldb_private::RangeVector<lldb::addr_t, size_t>;
   using FlashRange = FlashRangeVector::Entry;
   FlashRangeVector m_erased_flash_ranges;
+  // The mapped regions read with qXfer:lldb-memory-regions, sorted by
+  // address, and the stop they were read at.
+  std::vector<MemoryRegionInfo> m_memory_regions;
+  uint32_t m_memory_regions_stop_id;
+  bool m_memory_regions_valid;
 
   // Accessors
   bool IsRunning(lldb::StateType state) {
@@ -83,6 +83,7 @@
 #if KMP_STATS_ENABLED
 class kmp_stats_list;
 #endif
+struct kmp_live_stats_slot;
 
 #if KMP_USE_HIER_SCHED
 // Only include hierarchical scheduling if affinity is supported
@@ -1787,6 +1788,8 @@ typedef enum kmp_bar_pat { /* Barrier communication patterns */
                                2, /* Hypercube-embedded tree with min branching
                                      factor 2^n */
                            bp_hierarchical_bar = 3, /* Machine hierarchy tree */
+                           bp_dist_bar = 4, /* Two-level tree of groups sized
+                                               after the machine hierarchy */
                            bp_last_bar /* Placeholder to mark the end */
 } kmp_bar_pat_e;
 
@@ -1813,6 +1816,7 @@ typedef struct kmp_internal_control {
   kmp_proc_bind_t proc_bind; /* internal control for affinity  */
   kmp_int32 default_device; /* internal control for default device */
   struct kmp_internal_control *next;
+  // NOTE: new fields must also be compared in update_icvs()
 } kmp_internal_control_t;
 
 static inline void copy_icvs(kmp_internal_control_t *dst,
@@ -1820,6 +1824,26 @@ static inline void copy_icvs(kmp_internal_control_t *dst,
   *dst = *src;
 }
 
+// Same as copy_icvs, but does not write dst when it already holds the same
+// ICVs. Reforking a hot team with unchanged ICVs then leaves the copies cached
+// by its threads valid. Fields are compared one by one, as padding is not
+// preserved by copy_icvs: keep this in sync with kmp_internal_control_t.
+static inline void update_icvs(kmp_internal_control_t *dst,
+                               kmp_internal_control_t *src) {
+  if (dst->serial_nesting_level != src->serial_nesting_level ||
+      dst->dynamic != src->dynamic || dst->bt_set != src->bt_set ||
+      dst->blocktime != src->blocktime ||
+#if KMP_USE_MONITOR
+      dst->bt_intervals != src->bt_intervals ||
+#endif
+      dst->nproc != src->nproc || dst->thread_limit != src->thread_limit ||
+      dst->max_active_levels != src->max_active_levels ||
+      dst->sched.sched != src->sched.sched ||
+      dst->proc_bind != src->proc_bind ||
+      dst->default_device != src->default_device || dst->next != src->next)
+    copy_icvs(dst, src);
+}
+
 /* Thread barrier needs volatile barrier fields */
 typedef struct KMP_ALIGN_CACHE kmp_bstate {
   // th_fixed_icvs is aligned by virtue of kmp_bstate being aligned (and all
@@ -1846,6 +1870,8 @@ typedef struct KMP_ALIGN_CACHE kmp_bstate {
   kmp_uint8 offset;
   kmp_uint8 wait_flag;
   kmp_uint8 use_oncore_barrier;
+  kmp_uint32 dist_nproc; // Team size dist_group_size was computed for
+  kmp_uint32 dist_group_size; // Size of the groups of the dist barrier
 #if USE_DEBUGGER
   // The following field is intended for the debugger solely. Only the worker
   // thread itself accesses this field: the worker increases it by 1 when it
@@ -2171,15 +2197,29 @@ struct kmp_dephash_entry {
   kmp_depnode_list_t *last_mtxs;
   kmp_int32 last_flag;
   kmp_lock_t *mtx_lock; /* is referenced by depnodes w/mutexinoutset dep */
-  kmp_dephash_entry_t *next_in_bucket;
 };
 
+// Open addressing slot: the address is kept next to the entry pointer so that
+// probing does not touch the entries
+typedef struct kmp_dephash_slot {
+  kmp_intptr_t addr;
+  kmp_dephash_entry_t *entry; /* NULL if the slot is free */
+} kmp_dephash_slot_t;
+
+// Entries are carved out of chunks so that they are not allocated one by one
+// and do not move when the table grows
+typedef struct kmp_dephash_chunk {
+  struct kmp_dephash_chunk *next;
+  kmp_uint32 size; /* number of entries following the chunk header */
+  kmp_uint32 nused;
+} kmp_dephash_chunk_t;
+
 typedef struct kmp_dephash {
-  kmp_dephash_entry_t **buckets;
-  size_t size;
-  size_t generation;
+  kmp_dephash_slot_t *slots;
+  size_t size; /* number of slots, a power of two */
   kmp_uint32 nelements;
-  kmp_uint32 nconflicts;
+  kmp_uint32 shift; /* 64 - log2(size), for multiplicative hashing */
+  kmp_dephash_chunk_t *chunks; /* most recent first */
 } kmp_dephash_t;
 
 typedef struct kmp_task_affinity_info {
@@ -2302,6 +2342,14 @@ struct kmp_taskdata { /* aligned during dynamic allocation       */
 // Make sure padding above worked
 KMP_BUILD_ASSERT(sizeof(kmp_taskdata_t) % sizeof(void *) == 0);
 
+// Array of a lock-free task deque. When the deque grows, the array it replaces
+// is kept until the deque is freed, as thieves may still be reading it.
+typedef struct kmp_task_deque_array {
+  struct kmp_task_deque_array *tda_prev; // Array replaced by this one
+  kmp_int32 tda_size; // Number of slots, a power of two
+  std::atomic<kmp_taskdata_t *> *tda_tasks; // Slots, indexed modulo tda_size
+} kmp_task_deque_array_t;
+
 // Data for task team but per thread
 typedef struct kmp_base_thread_data {
   kmp_info_p *td_thr; // Pointer back to thread info
@@ -2309,13 +2357,21 @@ typedef struct kmp_base_thread_data {
   // queued?
   kmp_bootstrap_lock_t td_deque_lock; // Lock for accessing deque
   kmp_taskdata_t *
-      *td_deque; // Deque of tasks encountered by td_thr, dynamically allocated
+      *td_deque; // Deque of tasks given to td_thr, dynamically allocated
   kmp_int32 td_deque_size; // Size of deck
   kmp_uint32 td_deque_head; // Head of deque (will wrap)
   kmp_uint32 td_deque_tail; // Tail of deque (will wrap)
   kmp_int32 td_deque_ntasks; // Number of tasks in deque
+  // Lock-free (Chase-Lev) deque of the tasks pushed by td_thr itself: td_thr
+  // pushes and pops at td_lf_bottom, thieves take tasks at td_lf_top with a
+  // CAS. The locked deque above holds the tasks given by other threads and
+  // the tasks that were taken from this one but could not be executed.
+  std::atomic<kmp_task_deque_array_t *> td_lf_deque;
+  std::atomic<kmp_int64> td_lf_top; // Index of the oldest task
+  std::atomic<kmp_int64> td_lf_bottom; // Index after the newest task
   // GEH: shouldn't this be volatile since used in while-spin?
   kmp_int32 td_deque_last_stolen; // Thread number of last successful steal
+  kmp_int32 td_steal_fails; // Failed steals since the last successful one
 #ifdef BUILD_TIED_TASK_STACK
   kmp_task_stack_t td_susp_tied_tasks; // Stack of suspended tied tasks for task
 // scheduling constraint
@@ -2374,6 +2430,7 @@ typedef struct kmp_free_list {
   // threads
   void *th_free_list_other; // Non-self free list (to be returned to owner's
   // sync list)
+  kmp_uint32 th_free_list_self_count; // Blocks on the self free list
 } kmp_free_list_t;
 #endif
 #if KMP_NESTED_HOT_TEAMS
@@ -2520,6 +2577,9 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
 
   KMP_ALIGN_CACHE volatile kmp_int32
       th_next_waiting; /* gtid+1 of next thread on lock wait queue, 0 if none */
+#if KMP_USE_FUTEX
+  kmp_uint16 th_futex_spins[KMP_FUTEX_SPIN_SLOTS]; // futex lock spin budgets
+#endif
 
 #if (USE_FAST_MEMORY == 3) || (USE_FAST_MEMORY == 5)
 #define NUM_LISTS 4
@@ -2545,6 +2605,7 @@ typedef struct KMP_ALIGN_CACHE kmp_base_info {
 #if KMP_STATS_ENABLED
   kmp_stats_list *th_stats;
 #endif
+  struct kmp_live_stats_slot *th_live_stats; // always-on counters
 #if KMP_OS_UNIX
   std::atomic<bool> th_blocking;
 #endif
@@ -2594,6 +2655,10 @@ typedef int (*launch_t)(int gtid);
 #endif
 #define KMP_INLINE_ARGV_ENTRIES (int)(KMP_INLINE_ARGV_BYTES / KMP_PTR_SKIP)
 
+// Levels of the machine hierarchy kept to order steal victims; threads that
+// share no smaller subtree are treated as equally far apart.
+#define KMP_VICTIM_MAX_LEVELS 8
+
 typedef struct KMP_ALIGN_CACHE kmp_base_team {
   // Synchronization Data
   // ---------------------------------------------------------------------------
@@ -2664,6 +2729,11 @@ typedef struct KMP_ALIGN_CACHE kmp_base_team {
   int t_size_changed; // team size was changed?: 0: no, 1: yes, -1: changed via
   // omp_set_num_threads() call
   omp_allocator_handle_t t_def_allocator; /* default allocator */
+  // Machine hierarchy steal victims are picked by, see
+  // __kmp_get_victim_hierarchy
+  kmp_int32 t_victim_nproc; // team size the levels were taken for
+  kmp_uint32 t_victim_depth;
+  kmp_uint32 t_victim_skip[KMP_VICTIM_MAX_LEVELS];
 
 // Read/write by workers as well
 #if (KMP_ARCH_X86 || KMP_ARCH_X86_64)
@@ -3010,6 +3080,7 @@ extern const char *__kmp_speculative_statsfile;
 #endif // KMP_USE_ADAPTIVE_LOCKS
 
 extern int __kmp_display_env; /* TRUE or FALSE */
+extern int __kmp_live_stats_export; /* KMP_LIVE_STATS: export via shm */
 extern int __kmp_display_env_verbose; /* TRUE if OMP_DISPLAY_ENV=VERBOSE */
 extern int __kmp_omp_cancellation; /* TRUE or FALSE */
 
@@ -3349,6 +3420,9 @@ extern void __kmp_aux_display_affinity(int gtid, const char *format);
 
 extern void __kmp_cleanup_hierarchy();
 extern void __kmp_get_hierarchy(kmp_uint32 nproc, kmp_bstate_t *thr_bar);
+extern void __kmp_get_victim_hierarchy(kmp_team_t *team);
+extern kmp_int32 __kmp_get_victim_tid(kmp_team_t *team, kmp_int32 tid,
+                                      kmp_int32 rank, kmp_int32 nproc);
 
 #if KMP_USE_FUTEX
 
@@ -44,6 +44,56 @@ void __kmp_get_hierarchy(kmp_uint32 nproc, kmp_bstate_t *thr_bar) {
   thr_bar->skip_per_level = machine_hierarchy.skipPerLevel;
 }
 
+// Copies into the team the levels of the machine hierarchy that
+// __kmp_get_victim_tid orders its threads by. Called by the master when it
+// forks the team: the workers never read machine_hierarchy itself, which the
+// master of another team may resize, and reallocate, at any time.
+void __kmp_get_victim_hierarchy(kmp_team_t *team) {
+  kmp_uint32 nproc = team->t.t_nproc;
+  if (TCR_1(machine_hierarchy.uninitialized))
+    machine_hierarchy.init(NULL, nproc);
+  if (nproc > machine_hierarchy.base_num_threads)
+    machine_hierarchy.resize(nproc);
+
+  kmp_uint32 depth = 1;
+  while (depth < machine_hierarchy.depth && depth < KMP_VICTIM_MAX_LEVELS &&
+         machine_hierarchy.skipPerLevel[depth] < nproc) {
+    team->t.t_victim_skip[depth] = machine_hierarchy.skipPerLevel[depth];
+    ++depth;
+  }
+  team->t.t_victim_depth = depth;
+  team->t.t_victim_nproc = nproc;
+}
+
+// Returns the rank-th closest thread to tid, 1 <= rank < nproc, in a team of
+// nproc threads. Threads are ordered by the level of the smallest subtree of
+// the machine hierarchy they share with tid, then round-robin from tid within
+// a level. With compact affinity, threads sharing a cache thus come before the
+// other threads of the same socket, which come before remote ones.
+kmp_int32 __kmp_get_victim_tid(kmp_team_t *team, kmp_int32 tid, kmp_int32 rank,
+                               kmp_int32 nproc) {
+  KMP_DEBUG_ASSERT(rank > 0 && rank < nproc);
+  // A team whose hierarchy was not taken is treated as flat
+  kmp_uint32 depth = team->t.t_victim_depth;
+  const kmp_uint32 *skip = team->t.t_victim_skip;
+  // Subtree of the previous level, already enumerated
+  kmp_int32 prev_base = tid, prev_n = 1;
+  for (kmp_uint32 d = 1;; ++d) {
+    kmp_int32 base = 0, n = nproc;
+    if (d < depth && (kmp_int32)skip[d] < nproc) {
+      base = tid - tid % skip[d];
+      n = KMP_MIN(base + (kmp_int32)skip[d], nproc) - base;
+    }
+    // The previous subtree is contiguous within this one, so going around
+    // this one from the end of the previous one visits the new threads only
+    if (rank <= n - prev_n)
+      return base + (prev_base + prev_n - base + rank - 1) % n;
+    rank -= n - prev_n;
+    prev_base = base;
+    prev_n = n;
+  }
+}
+
 #if KMP_AFFINITY_SUPPORTED
 
 bool KMPAffinity::picked_api = false;
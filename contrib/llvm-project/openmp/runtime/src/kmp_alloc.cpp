@@ -1441,6 +1441,10 @@ typedef struct kmp_mem_desc { // Memory block descriptor
 } kmp_mem_desc_t;
 static int alignment = sizeof(void *); // let's align to pointer size
 
+// Default memory when memkind is not available, see below
+static void *__kmp_alloc_default_mem(int gtid, size_t size);
+static void __kmp_free_default_mem(int gtid, void *ptr, size_t size);
+
 void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t allocator) {
   void *ptr = NULL;
   kmp_allocator_t *al;
@@ -1524,7 +1528,7 @@ void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t allocator) {
     if (allocator == omp_high_bw_mem_alloc) {
       // ptr = NULL;
     } else {
-      ptr = __kmp_thread_malloc(__kmp_thread_from_gtid(gtid), desc.size_a);
+      ptr = __kmp_alloc_default_mem(gtid, desc.size_a);
     }
   } else if (al->pool_size > 0) {
     // custom allocator with pool size requested
@@ -1535,7 +1539,7 @@ void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t allocator) {
       KMP_TEST_THEN_ADD64((kmp_int64 *)&al->pool_used, -desc.size_a);
       if (al->fb == omp_atv_default_mem_fb) {
         al = (kmp_allocator_t *)omp_default_mem_alloc;
-        ptr = __kmp_thread_malloc(__kmp_thread_from_gtid(gtid), desc.size_a);
+        ptr = __kmp_alloc_default_mem(gtid, desc.size_a);
       } else if (al->fb == omp_atv_abort_fb) {
         KMP_ASSERT(0); // abort fallback requested
       } else if (al->fb == omp_atv_allocator_fb) {
@@ -1545,14 +1549,14 @@ void *__kmpc_alloc(int gtid, size_t size, omp_allocator_handle_t allocator) {
       } // else ptr == NULL;
     } else {
       // pool has enough space
-      ptr = __kmp_thread_malloc(__kmp_thread_from_gtid(gtid), desc.size_a);
+      ptr = __kmp_alloc_default_mem(gtid, desc.size_a);
       if (ptr == NULL && al->fb == omp_atv_abort_fb) {
         KMP_ASSERT(0); // abort fallback requested
       } // no sense to look for another fallback because of same internal alloc
     }
   } else {
     // custom allocator, pool size not requested
-    ptr = __kmp_thread_malloc(__kmp_thread_from_gtid(gtid), desc.size_a);
+    ptr = __kmp_alloc_default_mem(gtid, desc.size_a);
     if (ptr == NULL && al->fb == omp_atv_abort_fb) {
       KMP_ASSERT(0); // abort fallback requested
     } // no sense to look for another fallback because of same internal alloc
@@ -1623,7 +1627,7 @@ void __kmpc_free(int gtid, void *ptr, const omp_allocator_handle_t allocator) {
       (void)used; // to suppress compiler warning
       KMP_DEBUG_ASSERT(used >= desc.size_a);
     }
-    __kmp_thread_free(__kmp_thread_from_gtid(gtid), desc.ptr_alloc);
+    __kmp_free_default_mem(gtid, desc.ptr_alloc, desc.size_a);
   }
   KE_TRACE(10, ("__kmpc_free: T#%d freed %p (%p)\n", gtid, desc.ptr_alloc,
                 allocator));
@@ -1810,6 +1814,40 @@ void ___kmp_free(void *ptr KMP_SRC_LOC_DECL) {
 // Always use 128 bytes for determining buckets for caching memory blocks
 #define DCACHE_LINE 128
 
+// Bytes kept at most on each self free list. Blocks freed beyond that are
+// released to bget, which can coalesce them and reuse them for other sizes.
+#define KMP_FREE_LIST_HIGH_WATER (256 * 1024)
+
+// Puts the chain of blocks of size bytes on the empty self free list of the
+// thread, up to the high-water mark of the list, and releases the others.
+static void __kmp_fast_adopt_chain(kmp_info_t *this_thr, int index,
+                                   size_t size, void *chain) {
+  kmp_free_list_t *list = &this_thr->th.th_free_lists[index];
+  kmp_uint32 limit = KMP_FREE_LIST_HIGH_WATER / size;
+  kmp_uint32 count = 0;
+  void **link = &list->th_free_list_self;
+
+  KMP_DEBUG_ASSERT(*link == NULL);
+  while (chain != NULL && count < limit) {
+    *link = chain;
+    link = (void **)chain;
+    chain = *link;
+    ++count;
+  }
+  *link = NULL;
+  list->th_free_list_self_count = count;
+
+  if (chain != NULL)
+    __kmp_bget_dequeue(this_thr); /* Release any queued buffers */
+  while (chain != NULL) {
+    void *next = *((void **)chain);
+    brel(this_thr,
+         ((kmp_mem_descr_t *)((kmp_uintptr_t)chain - sizeof(kmp_mem_descr_t)))
+             ->ptr_allocated);
+    chain = next;
+  }
+}
+
 void *___kmp_fast_allocate(kmp_info_t *this_thr, size_t size KMP_SRC_LOC_DECL) {
   void *ptr;
   int num_lines;
@@ -1845,6 +1883,7 @@ void *___kmp_fast_allocate(kmp_info_t *this_thr, size_t size KMP_SRC_LOC_DECL) {
   if (ptr != NULL) {
     // pop the head of no-sync free list
     this_thr->th.th_free_lists[index].th_free_list_self = *((void **)ptr);
+    this_thr->th.th_free_lists[index].th_free_list_self_count--;
     KMP_DEBUG_ASSERT(
         this_thr ==
         ((kmp_mem_descr_t *)((kmp_uintptr_t)ptr - sizeof(kmp_mem_descr_t)))
@@ -1863,7 +1902,8 @@ void *___kmp_fast_allocate(kmp_info_t *this_thr, size_t size KMP_SRC_LOC_DECL) {
     }
     // push the rest of chain into no-sync free list (can be NULL if there was
     // the only block)
-    this_thr->th.th_free_lists[index].th_free_list_self = *((void **)ptr);
+    __kmp_fast_adopt_chain(this_thr, index, num_lines * DCACHE_LINE,
+                           *((void **)ptr));
     KMP_DEBUG_ASSERT(
         this_thr ==
         ((kmp_mem_descr_t *)((kmp_uintptr_t)ptr - sizeof(kmp_mem_descr_t)))
@@ -1936,9 +1976,13 @@ void ___kmp_fast_free(kmp_info_t *this_thr, void *ptr KMP_SRC_LOC_DECL) {
 
   alloc_thr = (kmp_info_t *)descr->ptr_aligned; // get thread owning the block
   if (alloc_thr == this_thr) {
+    if (this_thr->th.th_free_lists[index].th_free_list_self_count >=
+        KMP_FREE_LIST_HIGH_WATER / size)
+      goto free_call; // the list is at its high-water mark
     // push block to self no-sync free list, linking previous head (LIFO)
     *((void **)ptr) = this_thr->th.th_free_lists[index].th_free_list_self;
     this_thr->th.th_free_lists[index].th_free_list_self = ptr;
+    this_thr->th.th_free_lists[index].th_free_list_self_count++;
   } else {
     void *head = this_thr->th.th_free_lists[index].th_free_list_other;
     if (head == NULL) {
@@ -2062,3 +2106,40 @@ void __kmp_free_fast_memory(kmp_info_t *th) {
 }
 
 #endif // USE_FAST_MEMORY
+
+// Default memory is taken from the bget pool of the thread, like with
+// __kmp_thread_malloc, except for the blocks that fast memory caches without
+// rounding them up to more than twice their size. Those come from the free
+// lists of the thread, so that calling omp_alloc/omp_free in a loop on them
+// does not go through bget each time. The size of the block tells how it was
+// allocated when it is freed.
+static inline bool __kmp_default_mem_is_fast(size_t size) {
+#if USE_FAST_MEMORY == 3
+  // Fast memory rounds sizes up to 2, 4, 16 or 64 cache lines
+  return (size > DCACHE_LINE && size <= 4 * DCACHE_LINE) ||
+         (size > 8 * DCACHE_LINE && size <= 16 * DCACHE_LINE) ||
+         (size > 32 * DCACHE_LINE && size <= 64 * DCACHE_LINE);
+#else
+  return false;
+#endif
+}
+
+static void *__kmp_alloc_default_mem(int gtid, size_t size) {
+  kmp_info_t *th = __kmp_thread_from_gtid(gtid);
+#if USE_FAST_MEMORY
+  if (__kmp_default_mem_is_fast(size))
+    return __kmp_fast_allocate(th, size);
+#endif
+  return __kmp_thread_malloc(th, size);
+}
+
+static void __kmp_free_default_mem(int gtid, void *ptr, size_t size) {
+  kmp_info_t *th = __kmp_thread_from_gtid(gtid);
+#if USE_FAST_MEMORY
+  if (__kmp_default_mem_is_fast(size)) {
+    __kmp_fast_free(th, ptr);
+    return;
+  }
+#endif
+  __kmp_thread_free(th, ptr);
+}
@@ -13,6 +13,7 @@
 #include "kmp.h"
 #include "kmp_wait_release.h"
 #include "kmp_itt.h"
+#include "kmp_live_stats.h"
 #include "kmp_os.h"
 #include "kmp_stats.h"
 #include "ompt-specific.h"
@@ -32,7 +33,7 @@
 #define ngo_sync() __asm__ volatile("lock; addl $0,0(%%rsp)" ::: "memory")
 #else
 #define ngo_load(src) ((void)0)
-#define ngo_store_icvs(dst, src) copy_icvs((dst), (src))
+#define ngo_store_icvs(dst, src) update_icvs((dst), (src))
 #define ngo_store_go(dst, src) KMP_MEMCPY((dst), (src), CACHE_LINE)
 #define ngo_sync() ((void)0)
 #endif /* KMP_MIC && USE_NGO_STORES */
@@ -485,8 +486,8 @@ static void __kmp_tree_barrier_release(
           __kmp_init_implicit_task(team->t.t_ident,
                                    team->t.t_threads[child_tid], team,
                                    child_tid, FALSE);
-          copy_icvs(&team->t.t_implicit_task_taskdata[child_tid].td_icvs,
-                    &team->t.t_implicit_task_taskdata[0].td_icvs);
+          update_icvs(&team->t.t_implicit_task_taskdata[child_tid].td_icvs,
+                      &team->t.t_implicit_task_taskdata[0].td_icvs);
         }
       }
 #endif // KMP_BARRIER_ICV_PUSH
@@ -662,8 +663,8 @@ static void __kmp_hyper_barrier_release(
                   gtid, team->t.t_id, tid, bt));
 #if KMP_BARRIER_ICV_PUSH
     if (propagate_icvs) { // master already has ICVs in final destination; copy
-      copy_icvs(&thr_bar->th_fixed_icvs,
-                &team->t.t_implicit_task_taskdata[tid].td_icvs);
+      update_icvs(&thr_bar->th_fixed_icvs,
+                  &team->t.t_implicit_task_taskdata[tid].td_icvs);
     }
 #endif
   } else { // Handle fork barrier workers who aren't part of a team yet
@@ -760,7 +761,7 @@ static void __kmp_hyper_barrier_release(
 
 #if KMP_BARRIER_ICV_PUSH
         if (propagate_icvs) // push my fixed ICVs to my child
-          copy_icvs(&child_bar->th_fixed_icvs, &thr_bar->th_fixed_icvs);
+          update_icvs(&child_bar->th_fixed_icvs, &thr_bar->th_fixed_icvs);
 #endif // KMP_BARRIER_ICV_PUSH
 
         KA_TRACE(
@@ -782,8 +783,8 @@ static void __kmp_hyper_barrier_release(
       !KMP_MASTER_TID(tid)) { // copy ICVs locally to final dest
     __kmp_init_implicit_task(team->t.t_ident, team->t.t_threads[tid], team, tid,
                              FALSE);
-    copy_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
-              &thr_bar->th_fixed_icvs);
+    update_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
+                &thr_bar->th_fixed_icvs);
   }
 #endif
   KA_TRACE(
@@ -1138,23 +1139,24 @@ static void __kmp_hierarchical_barrier_release(
                              FALSE);
     if (KMP_MASTER_TID(
             tid)) { // master already has copy in final destination; copy
-      copy_icvs(&thr_bar->th_fixed_icvs,
-                &team->t.t_implicit_task_taskdata[tid].td_icvs);
+      update_icvs(&thr_bar->th_fixed_icvs,
+                  &team->t.t_implicit_task_taskdata[tid].td_icvs);
     } else if (__kmp_dflt_blocktime == KMP_MAX_BLOCKTIME &&
                thr_bar->use_oncore_barrier) { // optimization for inf blocktime
       if (!thr_bar->my_level) // I'm a leaf in the hierarchy (my_level==0)
         // leaves (on-core children) pull parent's fixed ICVs directly to local
         // ICV store
-        copy_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
-                  &thr_bar->parent_bar->th_fixed_icvs);
+        update_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
+                    &thr_bar->parent_bar->th_fixed_icvs);
       // non-leaves will get ICVs piggybacked with b_go via NGO store
     } else { // blocktime is not infinite; pull ICVs from parent's fixed ICVs
       if (thr_bar->my_level) // not a leaf; copy ICVs to my fixed ICVs child can
         // access
-        copy_icvs(&thr_bar->th_fixed_icvs, &thr_bar->parent_bar->th_fixed_icvs);
+        update_icvs(&thr_bar->th_fixed_icvs,
+                    &thr_bar->parent_bar->th_fixed_icvs);
       else // leaves copy parent's fixed ICVs directly to local ICV store
-        copy_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
-                  &thr_bar->parent_bar->th_fixed_icvs);
+        update_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
+                    &thr_bar->parent_bar->th_fixed_icvs);
     }
   }
 #endif // KMP_BARRIER_ICV_PUSH
@@ -1252,8 +1254,8 @@ static void __kmp_hierarchical_barrier_release(
 #if KMP_BARRIER_ICV_PUSH
     if (propagate_icvs && !KMP_MASTER_TID(tid))
       // non-leaves copy ICVs from fixed ICVs to local dest
-      copy_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
-                &thr_bar->th_fixed_icvs);
+      update_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
+                  &thr_bar->th_fixed_icvs);
 #endif // KMP_BARRIER_ICV_PUSH
   }
   KA_TRACE(20, ("__kmp_hierarchical_barrier_release: T#%d(%d:%d) exit for "
@@ -1261,6 +1263,259 @@ static void __kmp_hierarchical_barrier_release(
                 gtid, team->t.t_id, tid, bt));
 }
 
+// Distributed barrier
+/* Threads are split into groups of consecutive tids whose size matches a level
+   of the machine hierarchy, so that with compact affinity a group shares a
+   cache or a socket. Each group is led by its first thread. During the gather,
+   leaders wait for the members of their group and the master waits for its own
+   group and for the other leaders; the release goes the other way round. The
+   wait on any given flag is thus only shared by the threads of one group, and
+   the master's critical path is the number of groups plus the size of a
+   group, instead of the full team for linear or log(nproc) remote hops for
+   tree. All flags are the per-thread, cache-aligned b_arrived and b_go ones,
+   so waiting threads may go to sleep as with the other patterns. */
+
+// Returns the size of the groups for a team of nproc threads. It only depends
+// on nproc and on the lower levels of the machine hierarchy, which resizing
+// does not modify, so all the threads of a team agree on it.
+static kmp_uint32 __kmp_dist_barrier_group_size(kmp_bstate_t *thr_bar,
+                                                kmp_uint32 nproc) {
+  if (thr_bar->dist_nproc != nproc) {
+    // Default to a single group, i.e. the linear barrier
+    kmp_uint32 group_size = nproc;
+    kmp_uint32 best_cost = nproc + 1;
+    __kmp_get_hierarchy(nproc, thr_bar);
+    for (kmp_uint32 d = 1; d < thr_bar->depth; ++d) {
+      kmp_uint32 size = thr_bar->skip_per_level[d];
+      kmp_uint32 cost = size + (nproc + size - 1) / size;
+      if (cost < best_cost) {
+        group_size = size;
+        best_cost = cost;
+      }
+      if (size >= nproc)
+        break;
+    }
+    thr_bar->dist_group_size = group_size;
+    thr_bar->dist_nproc = nproc;
+  }
+  return thr_bar->dist_group_size;
+}
+
+// Waits for child_tid to arrive at the gather and adds its reduce data to ours
+static void __kmp_dist_barrier_wait_child(
+    enum barrier_type bt, kmp_info_t *this_thr, int gtid, int tid,
+    kmp_team_t *team, kmp_uint32 child_tid, kmp_uint64 new_state,
+    void (*reduce)(void *, void *) USE_ITT_BUILD_ARG(void *itt_sync_obj)) {
+  kmp_info_t *child_thr = team->t.t_threads[child_tid];
+  kmp_bstate_t *child_bar = &child_thr->th.th_bar[bt].bb;
+  KA_TRACE(20, ("__kmp_dist_barrier_gather: T#%d(%d:%d) wait T#%d(%d:%u) "
+                "arrived(%p) == %llu\n",
+                gtid, team->t.t_id, tid, __kmp_gtid_from_tid(child_tid, team),
+                team->t.t_id, child_tid, &child_bar->b_arrived, new_state));
+  kmp_flag_64 flag(&child_bar->b_arrived, new_state);
+  flag.wait(this_thr, FALSE USE_ITT_BUILD_ARG(itt_sync_obj));
+  ANNOTATE_BARRIER_END(child_thr);
+#if USE_ITT_BUILD && USE_ITT_NOTIFY
+  // Barrier imbalance - write min of the thread time and a child time to the
+  // thread.
+  if (__kmp_forkjoin_frames_mode == 2) {
+    this_thr->th.th_bar_min_time =
+        KMP_MIN(this_thr->th.th_bar_min_time, child_thr->th.th_bar_min_time);
+  }
+#endif
+  if (reduce) {
+    KA_TRACE(100, ("__kmp_dist_barrier_gather: T#%d(%d:%d) += T#%d(%d:%u)\n",
+                   gtid, team->t.t_id, tid,
+                   __kmp_gtid_from_tid(child_tid, team), team->t.t_id,
+                   child_tid));
+    ANNOTATE_REDUCE_AFTER(reduce);
+    OMPT_REDUCTION_DECL(this_thr, gtid);
+    OMPT_REDUCTION_BEGIN;
+    (*reduce)(this_thr->th.th_local.reduce_data,
+              child_thr->th.th_local.reduce_data);
+    OMPT_REDUCTION_END;
+    ANNOTATE_REDUCE_BEFORE(reduce);
+    ANNOTATE_REDUCE_BEFORE(&team->t.t_bar);
+  }
+}
+
+static void
+__kmp_dist_barrier_gather(enum barrier_type bt, kmp_info_t *this_thr, int gtid,
+                          int tid, void (*reduce)(void *, void *)
+                                       USE_ITT_BUILD_ARG(void *itt_sync_obj)) {
+  KMP_TIME_DEVELOPER_PARTITIONED_BLOCK(KMP_dist_gather);
+  kmp_team_t *team = this_thr->th.th_team;
+  kmp_bstate_t *thr_bar = &this_thr->th.th_bar[bt].bb;
+  kmp_info_t **other_threads = team->t.t_threads;
+  kmp_uint32 nproc = this_thr->th.th_team_nproc;
+  kmp_uint32 group_size = __kmp_dist_barrier_group_size(thr_bar, nproc);
+  kmp_uint32 leader_tid = tid - tid % group_size;
+  kmp_uint64 new_state = team->t.t_bar[bt].b_arrived + KMP_BARRIER_STATE_BUMP;
+
+  KA_TRACE(
+      20, ("__kmp_dist_barrier_gather: T#%d(%d:%d) enter for barrier type %d\n",
+           gtid, team->t.t_id, tid, bt));
+  KMP_DEBUG_ASSERT(this_thr == other_threads[this_thr->th.th_info.ds.ds_tid]);
+
+#if USE_ITT_BUILD && USE_ITT_NOTIFY
+  // Barrier imbalance - save arrive time to the thread
+  if (__kmp_forkjoin_frames_mode == 3 || __kmp_forkjoin_frames_mode == 2) {
+    this_thr->th.th_bar_arrive_time = this_thr->th.th_bar_min_time =
+        __itt_get_timestamp();
+  }
+#endif
+  if ((kmp_uint32)tid == leader_tid) {
+    // Leaders wait for the members of their group
+    kmp_uint32 group_end = KMP_MIN(leader_tid + group_size, nproc);
+    for (kmp_uint32 child_tid = tid + 1; child_tid < group_end; ++child_tid)
+      __kmp_dist_barrier_wait_child(bt, this_thr, gtid, tid, team, child_tid,
+                                    new_state,
+                                    reduce USE_ITT_BUILD_ARG(itt_sync_obj));
+    // The master then waits for the other leaders
+    if (KMP_MASTER_TID(tid))
+      for (kmp_uint32 child_tid = group_size; child_tid < nproc;
+           child_tid += group_size)
+        __kmp_dist_barrier_wait_child(bt, this_thr, gtid, tid, team, child_tid,
+                                      new_state,
+                                      reduce USE_ITT_BUILD_ARG(itt_sync_obj));
+  }
+
+  if (!KMP_MASTER_TID(tid)) { // Worker threads
+    kmp_int32 parent_tid = (kmp_uint32)tid == leader_tid ? 0 : leader_tid;
+
+    KA_TRACE(20,
+             ("__kmp_dist_barrier_gather: T#%d(%d:%d) releasing T#%d(%d:%d) "
+              "arrived(%p): %llu => %llu\n",
+              gtid, team->t.t_id, tid, __kmp_gtid_from_tid(parent_tid, team),
+              team->t.t_id, parent_tid, &thr_bar->b_arrived, thr_bar->b_arrived,
+              thr_bar->b_arrived + KMP_BARRIER_STATE_BUMP));
+
+    // Mark arrival to parent thread
+    /* After performing this write, a worker thread may not assume that the team
+       is valid any more - it could be deallocated by the master thread at any
+       time.  */
+    ANNOTATE_BARRIER_BEGIN(this_thr);
+    kmp_flag_64 flag(&thr_bar->b_arrived, other_threads[parent_tid]);
+    flag.release();
+  } else {
+    // Need to update the team arrived pointer if we are the master thread
+    team->t.t_bar[bt].b_arrived = new_state;
+    KA_TRACE(20, ("__kmp_dist_barrier_gather: T#%d(%d:%d) set team %d "
+                  "arrived(%p) = %llu\n",
+                  gtid, team->t.t_id, tid, team->t.t_id,
+                  &team->t.t_bar[bt].b_arrived, team->t.t_bar[bt].b_arrived));
+  }
+  KA_TRACE(20,
+           ("__kmp_dist_barrier_gather: T#%d(%d:%d) exit for barrier type %d\n",
+            gtid, team->t.t_id, tid, bt));
+}
+
+// Pushes the ICVs to child_tid if needed and releases it from the barrier
+static void __kmp_dist_barrier_release_child(enum barrier_type bt, int gtid,
+                                             int tid, kmp_team_t *team,
+                                             kmp_uint32 child_tid,
+                                             int propagate_icvs) {
+  kmp_info_t *child_thr = team->t.t_threads[child_tid];
+  kmp_bstate_t *child_bar = &child_thr->th.th_bar[bt].bb;
+#if KMP_BARRIER_ICV_PUSH
+  {
+    KMP_TIME_DEVELOPER_PARTITIONED_BLOCK(USER_icv_copy);
+    if (propagate_icvs) {
+      __kmp_init_implicit_task(team->t.t_ident, child_thr, team, child_tid,
+                               FALSE);
+      update_icvs(&team->t.t_implicit_task_taskdata[child_tid].td_icvs,
+                  &team->t.t_implicit_task_taskdata[0].td_icvs);
+    }
+  }
+#endif // KMP_BARRIER_ICV_PUSH
+  KA_TRACE(20, ("__kmp_dist_barrier_release: T#%d(%d:%d) releasing T#%d(%d:%u)"
+                "go(%p): %u => %u\n",
+                gtid, team->t.t_id, tid, __kmp_gtid_from_tid(child_tid, team),
+                team->t.t_id, child_tid, &child_bar->b_go, child_bar->b_go,
+                child_bar->b_go + KMP_BARRIER_STATE_BUMP));
+  // Release child from barrier
+  ANNOTATE_BARRIER_BEGIN(child_thr);
+  kmp_flag_64 flag(&child_bar->b_go, child_thr);
+  flag.release();
+}
+
+static void __kmp_dist_barrier_release(
+    enum barrier_type bt, kmp_info_t *this_thr, int gtid, int tid,
+    int propagate_icvs USE_ITT_BUILD_ARG(void *itt_sync_obj)) {
+  KMP_TIME_DEVELOPER_PARTITIONED_BLOCK(KMP_dist_release);
+  kmp_team_t *team;
+  kmp_bstate_t *thr_bar = &this_thr->th.th_bar[bt].bb;
+  kmp_uint32 nproc;
+  kmp_uint32 group_size;
+
+  if (!KMP_MASTER_TID(
+          tid)) { // Handle fork barrier workers who aren't part of a team yet
+    KA_TRACE(20, ("__kmp_dist_barrier_release: T#%d wait go(%p) == %u\n", gtid,
+                  &thr_bar->b_go, KMP_BARRIER_STATE_BUMP));
+    // Wait for leader or master thread to release us
+    kmp_flag_64 flag(&thr_bar->b_go, KMP_BARRIER_STATE_BUMP);
+    flag.wait(this_thr, TRUE USE_ITT_BUILD_ARG(itt_sync_obj));
+    ANNOTATE_BARRIER_END(this_thr);
+#if USE_ITT_BUILD && USE_ITT_NOTIFY
+    if ((__itt_sync_create_ptr && itt_sync_obj == NULL) || KMP_ITT_DEBUG) {
+      // In fork barrier where we could not get the object reliably (or
+      // ITTNOTIFY is disabled)
+      itt_sync_obj = __kmp_itt_barrier_object(gtid, bs_forkjoin_barrier, 0, -1);
+      // Cancel wait on previous parallel region...
+      __kmp_itt_task_starting(itt_sync_obj);
+
+      if (bt == bs_forkjoin_barrier && TCR_4(__kmp_global.g.g_done))
+        return;
+
+      itt_sync_obj = __kmp_itt_barrier_object(gtid, bs_forkjoin_barrier);
+      if (itt_sync_obj != NULL)
+        // Call prepare as early as possible for "new" barrier
+        __kmp_itt_task_finished(itt_sync_obj);
+    } else
+#endif /* USE_ITT_BUILD && USE_ITT_NOTIFY */
+        // Early exit for reaping threads releasing forkjoin barrier
+        if (bt == bs_forkjoin_barrier && TCR_4(__kmp_global.g.g_done))
+      return;
+
+    // The worker thread may now assume that the team is valid.
+    team = __kmp_threads[gtid]->th.th_team;
+    KMP_DEBUG_ASSERT(team != NULL);
+    tid = __kmp_tid_from_gtid(gtid);
+
+    TCW_4(thr_bar->b_go, KMP_INIT_BARRIER_STATE);
+    KA_TRACE(20,
+             ("__kmp_dist_barrier_release: T#%d(%d:%d) set go(%p) = %u\n", gtid,
+              team->t.t_id, tid, &thr_bar->b_go, KMP_INIT_BARRIER_STATE));
+    KMP_MB(); // Flush all pending memory write invalidates.
+  } else {
+    team = __kmp_threads[gtid]->th.th_team;
+    KMP_DEBUG_ASSERT(team != NULL);
+    KA_TRACE(20, ("__kmp_dist_barrier_release: T#%d(%d:%d) master enter for "
+                  "barrier type %d\n",
+                  gtid, team->t.t_id, tid, bt));
+  }
+  // The team size may have changed since the gather in the fork barrier
+  nproc = this_thr->th.th_team_nproc;
+  group_size = __kmp_dist_barrier_group_size(thr_bar, nproc);
+
+  if (tid % group_size == 0) {
+    // The master first releases the other leaders, so that they can release
+    // their groups while it releases its own
+    if (KMP_MASTER_TID(tid))
+      for (kmp_uint32 child_tid = group_size; child_tid < nproc;
+           child_tid += group_size)
+        __kmp_dist_barrier_release_child(bt, gtid, tid, team, child_tid,
+                                         propagate_icvs);
+    kmp_uint32 group_end = KMP_MIN((kmp_uint32)tid + group_size, nproc);
+    for (kmp_uint32 child_tid = tid + 1; child_tid < group_end; ++child_tid)
+      __kmp_dist_barrier_release_child(bt, gtid, tid, team, child_tid,
+                                       propagate_icvs);
+  }
+  KA_TRACE(
+      20, ("__kmp_dist_barrier_release: T#%d(%d:%d) exit for barrier type %d\n",
+           gtid, team->t.t_id, tid, bt));
+}
+
 // End of Barrier Algorithms
 
 // type traits for cancellable value
@@ -1301,6 +1556,7 @@ static int __kmp_barrier_template(enum barrier_type bt, int gtid, int is_split,
   kmp_team_t *team = this_thr->th.th_team;
   int status = 0;
   is_cancellable<cancellable> cancelled;
+  kmp_uint64 live_start = KMP_NOW();
 #if OMPT_SUPPORT && OMPT_OPTIONAL
   ompt_data_t *my_task_data;
   ompt_data_t *my_parallel_data;
@@ -1401,6 +1657,11 @@ static int __kmp_barrier_template(enum barrier_type bt, int gtid, int is_split,
                                    reduce USE_ITT_BUILD_ARG(itt_sync_obj));
         break;
       }
+      case bp_dist_bar: {
+        __kmp_dist_barrier_gather(bt, this_thr, gtid, tid,
+                                  reduce USE_ITT_BUILD_ARG(itt_sync_obj));
+        break;
+      }
       case bp_hierarchical_bar: {
         __kmp_hierarchical_barrier_gather(
             bt, this_thr, gtid, tid, reduce USE_ITT_BUILD_ARG(itt_sync_obj));
@@ -1512,6 +1773,11 @@ static int __kmp_barrier_template(enum barrier_type bt, int gtid, int is_split,
                                       FALSE USE_ITT_BUILD_ARG(itt_sync_obj));
           break;
         }
+        case bp_dist_bar: {
+          __kmp_dist_barrier_release(bt, this_thr, gtid, tid,
+                                     FALSE USE_ITT_BUILD_ARG(itt_sync_obj));
+          break;
+        }
         case bp_hierarchical_bar: {
           __kmp_hierarchical_barrier_release(
               bt, this_thr, gtid, tid, FALSE USE_ITT_BUILD_ARG(itt_sync_obj));
@@ -1587,6 +1853,8 @@ static int __kmp_barrier_template(enum barrier_type bt, int gtid, int is_split,
   }
 #endif
   ANNOTATE_BARRIER_END(&team->t.t_bar);
+  KMP_LIVE_STAT_INC(this_thr, barrier);
+  KMP_LIVE_STAT_ADD(this_thr, barrier_wait, KMP_NOW() - live_start);
 
   if (cancellable)
     return (int)cancelled;
@@ -1642,6 +1910,11 @@ void __kmp_end_split_barrier(enum barrier_type bt, int gtid) {
                                     FALSE USE_ITT_BUILD_ARG(NULL));
         break;
       }
+      case bp_dist_bar: {
+        __kmp_dist_barrier_release(bt, this_thr, gtid, tid,
+                                   FALSE USE_ITT_BUILD_ARG(NULL));
+        break;
+      }
       case bp_hierarchical_bar: {
         __kmp_hierarchical_barrier_release(bt, this_thr, gtid, tid,
                                            FALSE USE_ITT_BUILD_ARG(NULL));
@@ -1677,6 +1950,7 @@ void __kmp_join_barrier(int gtid) {
 #ifdef KMP_DEBUG
   int team_id;
 #endif /* KMP_DEBUG */
+  kmp_uint64 live_start = KMP_NOW();
 #if USE_ITT_BUILD
   void *itt_sync_obj = NULL;
 #if USE_ITT_NOTIFY
@@ -1788,6 +2062,11 @@ void __kmp_join_barrier(int gtid) {
                                NULL USE_ITT_BUILD_ARG(itt_sync_obj));
     break;
   }
+  case bp_dist_bar: {
+    __kmp_dist_barrier_gather(bs_forkjoin_barrier, this_thr, gtid, tid,
+                              NULL USE_ITT_BUILD_ARG(itt_sync_obj));
+    break;
+  }
   case bp_hierarchical_bar: {
     __kmp_hierarchical_barrier_gather(bs_forkjoin_barrier, this_thr, gtid, tid,
                                       NULL USE_ITT_BUILD_ARG(itt_sync_obj));
@@ -1899,6 +2178,8 @@ void __kmp_join_barrier(int gtid) {
            ("__kmp_join_barrier: T#%d(%d:%d) leaving\n", gtid, team_id, tid));
 
   ANNOTATE_BARRIER_END(&team->t.t_bar);
+  KMP_LIVE_STAT_INC(this_thr, barrier);
+  KMP_LIVE_STAT_ADD(this_thr, barrier_wait, KMP_NOW() - live_start);
 }
 
 // TODO release worker threads' fork barriers as we are ready instead of all at
@@ -1971,6 +2252,8 @@ void __kmp_fork_barrier(int gtid, int tid) {
     }
   } // master
 
+  // Workers wait here between parallel regions: account it as idle time.
+  kmp_uint64 live_start = KMP_NOW();
   switch (__kmp_barrier_release_pattern[bs_forkjoin_barrier]) {
   case bp_hyper_bar: {
     KMP_ASSERT(__kmp_barrier_release_branch_bits[bs_forkjoin_barrier]);
@@ -1978,6 +2261,11 @@ void __kmp_fork_barrier(int gtid, int tid) {
                                 TRUE USE_ITT_BUILD_ARG(itt_sync_obj));
     break;
   }
+  case bp_dist_bar: {
+    __kmp_dist_barrier_release(bs_forkjoin_barrier, this_thr, gtid, tid,
+                               TRUE USE_ITT_BUILD_ARG(itt_sync_obj));
+    break;
+  }
   case bp_hierarchical_bar: {
     __kmp_hierarchical_barrier_release(bs_forkjoin_barrier, this_thr, gtid, tid,
                                        TRUE USE_ITT_BUILD_ARG(itt_sync_obj));
@@ -1994,6 +2282,8 @@ void __kmp_fork_barrier(int gtid, int tid) {
                                  TRUE USE_ITT_BUILD_ARG(itt_sync_obj));
   }
   }
+  if (!KMP_MASTER_TID(tid))
+    KMP_LIVE_STAT_ADD(this_thr, idle, KMP_NOW() - live_start);
 
 #if OMPT_SUPPORT
   if (ompt_enabled.enabled &&
@@ -2068,10 +2358,10 @@ void __kmp_fork_barrier(int gtid, int tid) {
                ("__kmp_fork_barrier: T#%d(%d) is PULLing ICVs\n", gtid, tid));
       __kmp_init_implicit_task(team->t.t_ident, team->t.t_threads[tid], team,
                                tid, FALSE);
-      copy_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
-                &team->t.t_threads[0]
-                     ->th.th_bar[bs_forkjoin_barrier]
-                     .bb.th_fixed_icvs);
+      update_icvs(&team->t.t_implicit_task_taskdata[tid].td_icvs,
+                  &team->t.t_threads[0]
+                       ->th.th_bar[bs_forkjoin_barrier]
+                       .bb.th_fixed_icvs);
     }
   }
 #endif // KMP_BARRIER_ICV_PULL
@@ -2143,7 +2433,7 @@ void __kmp_setup_icv_copy(kmp_team_t *team, int new_nproc,
      own copies after the barrier. */
   KMP_DEBUG_ASSERT(team->t.t_threads[0]); // The threads arrays should be
   // allocated at this point
-  copy_icvs(
+  update_icvs(
       &team->t.t_threads[0]->th.th_bar[bs_forkjoin_barrier].bb.th_fixed_icvs,
       new_icvs);
   KF_TRACE(10, ("__kmp_setup_icv_copy: PULL: T#%d this_thread=%p team=%p\n", 0,
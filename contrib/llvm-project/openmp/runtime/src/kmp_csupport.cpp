@@ -1012,15 +1012,6 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
 
 #if KMP_USE_FUTEX
 
-#include <sys/syscall.h>
-#include <unistd.h>
-#ifndef FUTEX_WAIT
-#define FUTEX_WAIT 0
-#endif
-#ifndef FUTEX_WAKE
-#define FUTEX_WAKE 1
-#endif
-
 // Fast-path acquire futex lock
 #define KMP_ACQUIRE_FUTEX_LOCK(lock, gtid)                                     \
   {                                                                            \
@@ -1029,9 +1020,16 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
     KMP_MB();                                                                  \
     KMP_FSYNC_PREPARE(ftx);                                                    \
     kmp_int32 poll_val;                                                        \
+    bool spun = false;                                                         \
     while ((poll_val = KMP_COMPARE_AND_STORE_RET32(                            \
                 &(ftx->lk.poll), KMP_LOCK_FREE(futex),                         \
                 KMP_LOCK_BUSY(gtid_code, futex))) != KMP_LOCK_FREE(futex)) {   \
+      if (!spun) {                                                             \
+        spun = true;                                                           \
+        if (__kmp_spin_futex_lock(ftx, gtid, gtid_code))                       \
+          break;                                                               \
+        continue;                                                              \
+      }                                                                        \
       kmp_int32 cond = KMP_LOCK_STRIP(poll_val) & 1;                           \
       if (!cond) {                                                             \
         if (!KMP_COMPARE_AND_STORE_RET32(&(ftx->lk.poll), poll_val,            \
@@ -1042,8 +1040,7 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
         poll_val |= KMP_LOCK_BUSY(1, futex);                                   \
       }                                                                        \
       kmp_int32 rc;                                                            \
-      if ((rc = syscall(__NR_futex, &(ftx->lk.poll), FUTEX_WAIT, poll_val,     \
-                        NULL, NULL, 0)) != 0) {                                \
+      if ((rc = KMP_FUTEX_WAIT(&(ftx->lk.poll), poll_val)) != 0) {             \
         continue;                                                              \
       }                                                                        \
       gtid_code |= 1;                                                          \
@@ -1073,8 +1070,7 @@ __kmp_init_indirect_csptr(kmp_critical_name *crit, ident_t const *loc,
     kmp_int32 poll_val =                                                       \
         KMP_XCHG_FIXED32(&(ftx->lk.poll), KMP_LOCK_FREE(futex));               \
     if (KMP_LOCK_STRIP(poll_val) & 1) {                                        \
-      syscall(__NR_futex, &(ftx->lk.poll), FUTEX_WAKE,                         \
-              KMP_LOCK_BUSY(1, futex), NULL, NULL, 0);                         \
+      KMP_FUTEX_WAKE(&(ftx->lk.poll), KMP_LOCK_BUSY(1, futex));                \
     }                                                                          \
     KMP_MB();                                                                  \
     KMP_YIELD_OVERSUB();                                                       \
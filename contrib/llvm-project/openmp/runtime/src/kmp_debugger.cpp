@@ -212,6 +212,14 @@ kmp_omp_struct_info_t __kmp_omp_debug_struct_info = {
     offset_and_size_of(kmp_base_thread_data_t, td_deque_tail),
     offset_and_size_of(kmp_base_thread_data_t, td_deque_ntasks),
     offset_and_size_of(kmp_base_thread_data_t, td_deque_last_stolen),
+    offset_and_size_of(kmp_base_thread_data_t, td_lf_deque),
+    offset_and_size_of(kmp_base_thread_data_t, td_lf_top),
+    offset_and_size_of(kmp_base_thread_data_t, td_lf_bottom),
+
+    // kmp_task_deque_array_t.
+    sizeof(kmp_task_deque_array_t),
+    offset_and_size_of(kmp_task_deque_array_t, tda_size),
+    offset_and_size_of(kmp_task_deque_array_t, tda_tasks),
 
     // The last field.
     KMP_OMP_VERSION,
@@ -364,7 +364,9 @@ void __kmp_dispatch_init_algorithm(ident_t *loc, int gtid,
       // proportional to the number of chunks per thread up until
       // the maximum value of nproc.
       pr->u.p.parm3 = KMP_MIN(small_chunk + extras, nproc);
-      pr->u.p.parm4 = (id + 1) % nproc; // remember neighbour tid
+      // parm4 is the rank of the next victim in the order returned by
+      // __kmp_get_victim_tid, starting from the closest thread
+      pr->u.p.parm4 = 1;
       pr->u.p.st = st;
       if (traits_t<T>::type_size > 4) {
         // AC: TODO: check if 16-byte CAS available and use it to
@@ -1214,19 +1216,21 @@ int __kmp_dispatch_next_algorithm(int gtid,
         int idx = (th->th.th_dispatch->th_disp_index - 1) %
                   __kmp_dispatch_num_buffers; // current loop index
         // note: victim thread can potentially execute another loop
-        // TODO: algorithm of searching for a victim
-        // should be cleaned up and measured
+        // Victims are tried from the closest to the farthest in the machine
+        // hierarchy, starting from the last one we stole from
         while ((!status) && (while_limit != ++while_index)) {
           dispatch_private_info_template<T> *victim;
           T remaining;
-          T victimIdx = pr->u.p.parm4;
-          T oldVictimIdx = victimIdx ? victimIdx - 1 : nproc - 1;
+          T victimRank = pr->u.p.parm4;
+          T oldVictimRank = victimRank > 1 ? victimRank - 1 : nproc - 1;
+          T victimIdx = __kmp_get_victim_tid(team, tid, victimRank, nproc);
           victim = reinterpret_cast<dispatch_private_info_template<T> *>(
               &other_threads[victimIdx]->th.th_dispatch->th_disp_buffer[idx]);
           KMP_DEBUG_ASSERT(victim);
           while ((victim == pr || id != victim->u.p.static_steal_counter) &&
-                 oldVictimIdx != victimIdx) {
-            victimIdx = (victimIdx + 1) % nproc;
+                 oldVictimRank != victimRank) {
+            victimRank = victimRank % (nproc - 1) + 1;
+            victimIdx = __kmp_get_victim_tid(team, tid, victimRank, nproc);
             victim = reinterpret_cast<dispatch_private_info_template<T> *>(
                 &other_threads[victimIdx]->th.th_dispatch->th_disp_buffer[idx]);
             KMP_DEBUG_ASSERT(victim);
@@ -1237,7 +1241,7 @@ int __kmp_dispatch_next_algorithm(int gtid,
             // because no victim passed kmp_init_dispatch yet
           }
           if (victim->u.p.count + 2 > (UT)victim->u.p.ub) {
-            pr->u.p.parm4 = (victimIdx + 1) % nproc; // shift start tid
+            pr->u.p.parm4 = victimRank % (nproc - 1) + 1; // shift start victim
             continue; // not enough chunks to steal, goto next victim
           }
 
@@ -1248,7 +1252,7 @@ int __kmp_dispatch_next_algorithm(int gtid,
           if (victim->u.p.count >= limit ||
               (remaining = limit - victim->u.p.count) < 2) {
             __kmp_release_lock(lck, gtid);
-            pr->u.p.parm4 = (victimIdx + 1) % nproc; // next victim
+            pr->u.p.parm4 = victimRank % (nproc - 1) + 1; // next victim
             continue; // not enough chunks to steal
           }
           // stealing succeeded, reduce victim's ub by 1/4 of undone chunks or
@@ -1265,7 +1269,7 @@ int __kmp_dispatch_next_algorithm(int gtid,
           __kmp_release_lock(lck, gtid);
 
           KMP_DEBUG_ASSERT(init + 1 <= limit);
-          pr->u.p.parm4 = victimIdx; // remember victim to steal from
+          pr->u.p.parm4 = victimRank; // remember victim to steal from
           status = 1;
           while_index = 0;
           // now update own count and ub with stolen range but init chunk
@@ -1313,20 +1317,22 @@ int __kmp_dispatch_next_algorithm(int gtid,
         int idx = (th->th.th_dispatch->th_disp_index - 1) %
                   __kmp_dispatch_num_buffers; // current loop index
         // note: victim thread can potentially execute another loop
-        // TODO: algorithm of searching for a victim
-        // should be cleaned up and measured
+        // Victims are tried from the closest to the farthest in the machine
+        // hierarchy, starting from the last one we stole from
         while ((!status) && (while_limit != ++while_index)) {
           dispatch_private_info_template<T> *victim;
           union_i4 vold, vnew;
           kmp_int32 remaining;
-          T victimIdx = pr->u.p.parm4;
-          T oldVictimIdx = victimIdx ? victimIdx - 1 : nproc - 1;
+          T victimRank = pr->u.p.parm4;
+          T oldVictimRank = victimRank > 1 ? victimRank - 1 : nproc - 1;
+          T victimIdx = __kmp_get_victim_tid(team, tid, victimRank, nproc);
           victim = reinterpret_cast<dispatch_private_info_template<T> *>(
               &other_threads[victimIdx]->th.th_dispatch->th_disp_buffer[idx]);
           KMP_DEBUG_ASSERT(victim);
           while ((victim == pr || id != victim->u.p.static_steal_counter) &&
-                 oldVictimIdx != victimIdx) {
-            victimIdx = (victimIdx + 1) % nproc;
+                 oldVictimRank != victimRank) {
+            victimRank = victimRank % (nproc - 1) + 1;
+            victimIdx = __kmp_get_victim_tid(team, tid, victimRank, nproc);
             victim = reinterpret_cast<dispatch_private_info_template<T> *>(
                 &other_threads[victimIdx]->th.th_dispatch->th_disp_buffer[idx]);
             KMP_DEBUG_ASSERT(victim);
@@ -1336,7 +1342,7 @@ int __kmp_dispatch_next_algorithm(int gtid,
             // no victim is ready yet to participate in stealing
             // because no victim passed kmp_init_dispatch yet
           }
-          pr->u.p.parm4 = victimIdx; // new victim found
+          pr->u.p.parm4 = victimRank; // new victim found
           while (1) { // CAS loop if victim has enough chunks to steal
             vold.b = *(volatile kmp_int64 *)(&victim->u.p.count);
             vnew = vold;
@@ -1344,7 +1350,8 @@ int __kmp_dispatch_next_algorithm(int gtid,
             KMP_DEBUG_ASSERT((vnew.p.ub - 1) * (UT)chunk <= trip);
             if (vnew.p.count >= (UT)vnew.p.ub ||
                 (remaining = vnew.p.ub - vnew.p.count) < 2) {
-              pr->u.p.parm4 = (victimIdx + 1) % nproc; // shift start victim id
+              // shift start victim
+              pr->u.p.parm4 = victimRank % (nproc - 1) + 1;
               break; // not enough chunks to steal, goto next victim
             }
             if (remaining > 3) {
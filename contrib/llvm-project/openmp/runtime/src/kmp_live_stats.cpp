@@ -0,0 +1,161 @@
+/*
+ * kmp_live_stats.cpp -- Always-on per-thread runtime counters.
+ */
+
+//===----------------------------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "kmp_live_stats.h"
+#include "kmp_str.h"
+#include "kmp_wrapper_getpid.h"
+
+#if KMP_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static char const *__kmp_live_stat_names[] = {
+#define KMP_LIVE_STAT_NAME(name, desc) #name,
+    KMP_FOREACH_LIVE_STAT(KMP_LIVE_STAT_NAME)
+#undef KMP_LIVE_STAT_NAME
+};
+
+// The exported segment, NULL if the slots are private to the process.
+static kmp_live_stats_header_t *__kmp_live_stats_shm = NULL;
+static kmp_live_stats_slot_t *__kmp_live_stats_slots = NULL;
+static size_t __kmp_live_stats_shm_size = 0;
+static char __kmp_live_stats_shm_name[64];
+// Slot of the threads a forked child inherits; nobody reads it.
+static kmp_live_stats_slot_t __kmp_live_stats_dropped_slot;
+
+void __kmp_live_stats_init(void) {
+#if KMP_OS_UNIX
+  if (!__kmp_live_stats_export || __kmp_live_stats_shm != NULL)
+    return;
+
+  size_t hdr_size = (sizeof(kmp_live_stats_header_t) + CACHE_LINE - 1) &
+                    ~(size_t)(CACHE_LINE - 1);
+  size_t size = hdr_size + KMP_LIVE_STATS_MAX_SLOTS *
+                               sizeof(kmp_live_stats_slot_t);
+  KMP_SNPRINTF(__kmp_live_stats_shm_name, sizeof(__kmp_live_stats_shm_name),
+               "/libomp-stats.%d", (int)getpid());
+
+  // Exclusive creation: never attach to a segment left over by a previous
+  // process with the same pid.
+  shm_unlink(__kmp_live_stats_shm_name);
+  int fd = shm_open(__kmp_live_stats_shm_name, O_CREAT | O_EXCL | O_RDWR,
+                    S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    KE_TRACE(10, ("__kmp_live_stats_init: shm_open(%s) failed\n",
+                  __kmp_live_stats_shm_name));
+    return;
+  }
+  void *addr = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    KE_TRACE(10, ("__kmp_live_stats_init: cannot map %s\n",
+                  __kmp_live_stats_shm_name));
+    shm_unlink(__kmp_live_stats_shm_name);
+    return;
+  }
+
+  // The new segment is zero filled.
+  kmp_live_stats_header_t *hdr = (kmp_live_stats_header_t *)addr;
+  hdr->version = KMP_LIVE_STATS_VERSION;
+  hdr->nstats = KMP_LIVE_LAST;
+  hdr->nslots = KMP_LIVE_STATS_MAX_SLOTS;
+  hdr->header_size = (kmp_uint32)hdr_size;
+  hdr->slot_size = (kmp_uint32)sizeof(kmp_live_stats_slot_t);
+#if KMP_OS_UNIX && (KMP_ARCH_X86 || KMP_ARCH_X86_64)
+  hdr->ticks_per_msec = __kmp_ticks_per_msec;
+#else
+  hdr->ticks_per_msec = KMP_USEC_PER_SEC; // KMP_NOW() is in nanoseconds
+#endif
+  hdr->pid = getpid();
+  for (int i = 0; i < KMP_LIVE_LAST; ++i)
+    KMP_STRNCPY_S(hdr->names[i], KMP_LIVE_STATS_NAME_LEN,
+                  __kmp_live_stat_names[i], KMP_LIVE_STATS_NAME_LEN - 1);
+  __kmp_live_stats_slots =
+      (kmp_live_stats_slot_t *)((char *)addr + hdr_size);
+  for (int i = 0; i < KMP_LIVE_STATS_MAX_SLOTS; ++i)
+    __kmp_live_stats_slots[i].gtid = -1;
+  // Readers check the magic last, once the rest of the header is valid.
+  KMP_MB();
+  hdr->magic = KMP_LIVE_STATS_MAGIC;
+  __kmp_live_stats_shm = hdr;
+  __kmp_live_stats_shm_size = size;
+  KA_TRACE(10, ("__kmp_live_stats_init: exported %s (%d slots)\n",
+                __kmp_live_stats_shm_name, KMP_LIVE_STATS_MAX_SLOTS));
+#endif
+}
+
+void __kmp_live_stats_fini(void) {
+#if KMP_OS_UNIX
+  if (__kmp_live_stats_shm == NULL)
+    return;
+  // The name is removed so that the segment goes away with the process, but
+  // the mapping is kept: threads that were not reaped may still update it.
+  shm_unlink(__kmp_live_stats_shm_name);
+#endif
+}
+
+static bool __kmp_live_stats_is_shared(kmp_live_stats_slot_t *slot) {
+  return __kmp_live_stats_slots != NULL && slot >= __kmp_live_stats_slots &&
+         slot < __kmp_live_stats_slots + KMP_LIVE_STATS_MAX_SLOTS;
+}
+
+void __kmp_live_stats_attach(kmp_info_t *th, int gtid) {
+  kmp_live_stats_slot_t *slot;
+  if (__kmp_live_stats_slots != NULL && gtid >= 0 &&
+      gtid < KMP_LIVE_STATS_MAX_SLOTS) {
+    slot = &__kmp_live_stats_slots[gtid];
+    memset(slot->values, 0, sizeof(slot->values));
+  } else {
+    slot = (kmp_live_stats_slot_t *)__kmp_allocate(
+        sizeof(kmp_live_stats_slot_t));
+  }
+  slot->gtid = gtid;
+  th->th.th_live_stats = slot;
+}
+
+// The segment belongs to the parent process: unmap it in the child. The
+// inherited threads that had a slot in it, including the one that forked,
+// which may be in a parallel region or a task, count into a private dummy slot
+// from then on.
+void __kmp_live_stats_atfork_child(void) {
+#if KMP_OS_UNIX
+  if (__kmp_live_stats_shm == NULL)
+    return;
+  for (int i = 0; i < __kmp_threads_capacity; ++i) {
+    kmp_info_t *th = __kmp_threads[i];
+    if (th != NULL && __kmp_live_stats_is_shared(th->th.th_live_stats))
+      th->th.th_live_stats = &__kmp_live_stats_dropped_slot;
+  }
+  munmap(__kmp_live_stats_shm, __kmp_live_stats_shm_size);
+  __kmp_live_stats_shm = NULL;
+  __kmp_live_stats_slots = NULL;
+  __kmp_live_stats_shm_size = 0;
+#endif
+}
+
+void __kmp_live_stats_detach(kmp_info_t *th) {
+  kmp_live_stats_slot_t *slot = th->th.th_live_stats;
+  if (slot == NULL)
+    return;
+  th->th.th_live_stats = NULL;
+  if (__kmp_live_stats_is_shared(slot))
+    slot->gtid = -1;
+  else if (slot != &__kmp_live_stats_dropped_slot)
+    __kmp_free(slot);
+}
+
+// end of file //
@@ -0,0 +1,96 @@
+/*
+ * kmp_live_stats.h -- Always-on per-thread runtime counters.
+ */
+
+//===----------------------------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KMP_LIVE_STATS_H
+#define KMP_LIVE_STATS_H
+
+#include "kmp.h"
+
+/* Unlike the KMP_STATS_ENABLED instrumentation, these counters are compiled
+   into every build. Each thread owns a slot and updates it with plain stores,
+   so keeping them costs no atomics and no shared cache lines.
+
+   With KMP_LIVE_STATS=1 the slots live in a POSIX shared memory segment named
+   "/libomp-stats.<pid>", which an external tool can map read-only and sample
+   while the program runs. The segment is laid out as follows:
+
+     kmp_live_stats_header_t                      (magic, version, names, ...)
+     kmp_live_stats_slot_t slots[header.nslots]   (one per gtid, cache aligned)
+
+   The slots start header.header_size bytes into the segment and are
+   header.slot_size bytes apart. A reader must check, in this order, that
+   header.magic is KMP_LIVE_STATS_MAGIC (it is stored last, once the rest of
+   the header is valid), that header.version is the KMP_LIVE_STATS_VERSION it
+   was built with, and that header_size, slot_size and nstats match its own
+   sizeof(kmp_live_stats_header_t) rounded up to CACHE_LINE,
+   sizeof(kmp_live_stats_slot_t) and KMP_LIVE_LAST. Any change to the layout
+   bumps the version.
+
+   A slot whose gtid is -1 is unused. Times are in ticks of the clock returned
+   by KMP_NOW(), header.ticks_per_msec converts them to milliseconds. Values
+   are read without synchronization, so a reader may see a counter that lags
+   its thread by a few updates, but never a torn 64-bit value on the 64-bit
+   targets.
+
+   A child process created by fork() unmaps the segment of its parent, and
+   exports one of its own under its own pid if KMP_LIVE_STATS is set. */
+
+// name, description
+#define KMP_FOREACH_LIVE_STAT(macro)                                           \
+  macro(parallel, "parallel regions forked")                                   \
+  macro(barrier, "barriers passed")                                            \
+  macro(barrier_wait, "ticks spent in barriers")                               \
+  macro(idle, "ticks spent waiting for work in the fork barrier")              \
+  macro(task_executed, "explicit tasks executed")                              \
+  macro(task_steal_attempt, "attempts to steal a task")                        \
+  macro(task_steal, "tasks stolen")
+
+#define KMP_LIVE_STAT_ENUM(name, desc) KMP_LIVE_##name,
+enum kmp_live_stat_id {
+  KMP_FOREACH_LIVE_STAT(KMP_LIVE_STAT_ENUM) KMP_LIVE_LAST
+};
+#undef KMP_LIVE_STAT_ENUM
+
+#define KMP_LIVE_STATS_MAGIC 0x4c4d5053 /* "SPML" */
+#define KMP_LIVE_STATS_VERSION 2
+#define KMP_LIVE_STATS_MAX_SLOTS 1024
+#define KMP_LIVE_STATS_NAME_LEN 32
+
+typedef struct kmp_live_stats_header {
+  kmp_uint32 magic;
+  kmp_uint32 version;
+  kmp_uint32 nstats; // KMP_LIVE_LAST
+  kmp_uint32 nslots; // KMP_LIVE_STATS_MAX_SLOTS
+  kmp_uint32 header_size; // offset of the first slot
+  kmp_uint32 slot_size; // sizeof(kmp_live_stats_slot_t)
+  kmp_uint64 ticks_per_msec;
+  kmp_int64 pid;
+  char names[KMP_LIVE_LAST][KMP_LIVE_STATS_NAME_LEN];
+} kmp_live_stats_header_t;
+
+typedef struct KMP_ALIGN_CACHE kmp_live_stats_slot {
+  kmp_int32 gtid; // owner, -1 if unused
+  kmp_uint64 values[KMP_LIVE_LAST];
+} kmp_live_stats_slot_t;
+
+// Only the owning thread updates its slot, so no atomics are needed.
+#define KMP_LIVE_STAT_ADD(thr, name, v)                                        \
+  ((thr)->th.th_live_stats->values[KMP_LIVE_##name] += (v))
+#define KMP_LIVE_STAT_INC(thr, name) KMP_LIVE_STAT_ADD(thr, name, 1)
+
+extern void __kmp_live_stats_init(void);
+extern void __kmp_live_stats_fini(void);
+extern void __kmp_live_stats_attach(kmp_info_t *th, int gtid);
+extern void __kmp_live_stats_detach(kmp_info_t *th);
+extern void __kmp_live_stats_atfork_child(void);
+
+#endif // KMP_LIVE_STATS_H
@@ -23,22 +23,6 @@
 
 #include "tsan_annotations.h"
 
-#if KMP_USE_FUTEX
-#include <sys/syscall.h>
-#include <unistd.h>
-// We should really include <futex.h>, but that causes compatibility problems on
-// different Linux* OS distributions that either require that you include (or
-// break when you try to include) <pci/types.h>. Since all we need is the two
-// macros below (which are part of the kernel ABI, so can't change) we just
-// define the constants here and don't include <futex.h>
-#ifndef FUTEX_WAIT
-#define FUTEX_WAIT 0
-#endif
-#ifndef FUTEX_WAKE
-#define FUTEX_WAKE 1
-#endif
-#endif
-
 /* Implement spin locks for internal library use.             */
 /* The algorithm implemented is Lamport's bakery lock [1974]. */
 
@@ -314,6 +298,43 @@ static inline bool __kmp_is_futex_lock_nestable(kmp_futex_lock_t *lck) {
   return lck->lk.depth_locked != -1;
 }
 
+// Spins on a contended futex lock, trying to acquire it, before the caller
+// falls back to sleeping. The number of iterations follows a running average
+// of the iterations it took to get the lock, and is halved each time spinning
+// does not get it, so short critical sections are waited for in user space and
+// long ones quickly go to the kernel. Spinning stops as soon as other threads
+// are asleep on the lock, or if the machine is oversubscribed, as the owner may
+// then need the processor to release it.
+bool __kmp_spin_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid,
+                           kmp_int32 gtid_code) {
+  if (gtid < 0 || KMP_OVERSUBSCRIBED)
+    return false;
+  kmp_uint16 *budget =
+      &__kmp_threads[gtid]->th.th_futex_spins[KMP_FUTEX_SPIN_SLOT(lck)];
+  kmp_int32 spins = *budget;
+  kmp_int32 max_spins = KMP_MIN(KMP_FUTEX_MAX_SPINS, 2 * spins + 10);
+  kmp_int32 count;
+  bool acquired = false;
+  for (count = 0; count < max_spins; ++count) {
+    kmp_int32 poll_val = TCR_4(lck->lk.poll);
+    if (poll_val == KMP_LOCK_FREE(futex)) {
+      if (KMP_COMPARE_AND_STORE_ACQ32(&(lck->lk.poll), KMP_LOCK_FREE(futex),
+                                      KMP_LOCK_BUSY(gtid_code, futex))) {
+        acquired = true;
+        break;
+      }
+    } else if (KMP_LOCK_STRIP(poll_val) & 1) {
+      break; // there are sleepers already, queue up behind them
+    }
+    KMP_CPU_PAUSE();
+  }
+  if (acquired)
+    *budget = (kmp_uint16)(spins + (count - spins) / 8);
+  else
+    *budget = (kmp_uint16)(spins / 2);
+  return acquired;
+}
+
 __forceinline static int
 __kmp_acquire_futex_lock_timed_template(kmp_futex_lock_t *lck, kmp_int32 gtid) {
   kmp_int32 gtid_code = (gtid + 1) << 1;
@@ -332,11 +353,20 @@ __kmp_acquire_futex_lock_timed_template(kmp_futex_lock_t *lck, kmp_int32 gtid) {
                   lck, lck->lk.poll, gtid));
 
   kmp_int32 poll_val;
+  bool spun = false;
 
   while ((poll_val = KMP_COMPARE_AND_STORE_RET32(
               &(lck->lk.poll), KMP_LOCK_FREE(futex),
               KMP_LOCK_BUSY(gtid_code, futex))) != KMP_LOCK_FREE(futex)) {
 
+    // Before the first sleep, try to get the lock by spinning.
+    if (!spun) {
+      spun = true;
+      if (__kmp_spin_futex_lock(lck, gtid, gtid_code))
+        break;
+      continue;
+    }
+
     kmp_int32 cond = KMP_LOCK_STRIP(poll_val) & 1;
     KA_TRACE(
         1000,
@@ -373,8 +403,7 @@ __kmp_acquire_futex_lock_timed_template(kmp_futex_lock_t *lck, kmp_int32 gtid) {
          lck, gtid, poll_val));
 
     kmp_int32 rc;
-    if ((rc = syscall(__NR_futex, &(lck->lk.poll), FUTEX_WAIT, poll_val, NULL,
-                      NULL, 0)) != 0) {
+    if ((rc = KMP_FUTEX_WAIT(&(lck->lk.poll), poll_val)) != 0) {
       KA_TRACE(1000, ("__kmp_acquire_futex_lock: lck:%p, T#%d futex_wait(0x%x) "
                       "failed (rc=%d errno=%d)\n",
                       lck, gtid, poll_val, rc, errno));
@@ -453,8 +482,7 @@ int __kmp_release_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid) {
     KA_TRACE(1000,
              ("__kmp_release_futex_lock: lck:%p, T#%d futex_wake 1 thread\n",
               lck, gtid));
-    syscall(__NR_futex, &(lck->lk.poll), FUTEX_WAKE, KMP_LOCK_BUSY(1, futex),
-            NULL, NULL, 0);
+    KMP_FUTEX_WAKE(&(lck->lk.poll), KMP_LOCK_BUSY(1, futex));
   }
 
   KMP_MB(); /* Flush all pending memory write invalidates.  */
@@ -159,13 +159,44 @@ extern void __kmp_destroy_nested_tas_lock(kmp_tas_lock_t *lck);
 #define KMP_LOCK_ACQUIRED_NEXT 0
 #ifndef KMP_USE_FUTEX
 #define KMP_USE_FUTEX                                                          \
-  (KMP_OS_LINUX && !KMP_OS_CNK &&                                              \
+  (((KMP_OS_LINUX && !KMP_OS_CNK) || KMP_OS_FREEBSD) &&                        \
    (KMP_ARCH_X86 || KMP_ARCH_X86_64 || KMP_ARCH_ARM || KMP_ARCH_AARCH64))
 #endif
 #if KMP_USE_FUTEX
 
+// The futex lock sleeps with futex(2) on Linux* OS, and with the equivalent
+// _umtx_op(2) operations on FreeBSD*. KMP_FUTEX_WAIT returns 0 once the thread
+// was woken up; on FreeBSD* it also returns 0 if *addr did not hold val.
+#if KMP_OS_FREEBSD
+#include <sys/types.h>
+#include <sys/umtx.h>
+#define KMP_FUTEX_WAIT(addr, val)                                              \
+  _umtx_op((void *)(addr), UMTX_OP_WAIT_UINT_PRIVATE, (kmp_uint32)(val), NULL, \
+           NULL)
+#define KMP_FUTEX_WAKE(addr, n)                                                \
+  _umtx_op((void *)(addr), UMTX_OP_WAKE_PRIVATE, (n), NULL, NULL)
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+// We should really include <futex.h>, but that causes compatibility problems on
+// different Linux* OS distributions that either require that you include (or
+// break when you try to include) <pci/types.h>. Since all we need is the two
+// macros below (which are part of the kernel ABI, so can't change) we just
+// define the constants here and don't include <futex.h>
+#ifndef FUTEX_WAIT
+#define FUTEX_WAIT 0
+#endif
+#ifndef FUTEX_WAKE
+#define FUTEX_WAKE 1
+#endif
+#define KMP_FUTEX_WAIT(addr, val)                                              \
+  syscall(__NR_futex, (addr), FUTEX_WAIT, (val), NULL, NULL, 0)
+#define KMP_FUTEX_WAKE(addr, n)                                                \
+  syscall(__NR_futex, (addr), FUTEX_WAKE, (n), NULL, NULL, 0)
+#endif
+
 // ----------------------------------------------------------------------------
-// futex locks.  futex locks are only available on Linux* OS.
+// futex locks.  futex locks are only available on Linux* OS and FreeBSD*.
 //
 // Like non-nested test and set lock, non-nested futex locks use the memory
 // allocated by the compiler for the lock, rather than a pointer to it.
@@ -200,6 +231,17 @@ typedef union kmp_futex_lock kmp_futex_lock_t;
     { KMP_LOCK_FREE(futex), 0 }                                                \
   }
 
+// A contended futex lock is first spun on for a while before the thread goes
+// to sleep in the kernel. The spin budget adapts to the waits observed on the
+// lock; since the lock itself has no room for it, each thread keeps budgets
+// in a small table indexed by lock address (th_futex_spins).
+#define KMP_FUTEX_SPIN_SLOTS 8
+#define KMP_FUTEX_MAX_SPINS 512
+#define KMP_FUTEX_SPIN_SLOT(lck)                                               \
+  ((((kmp_uintptr_t)(lck)) >> 3) & (KMP_FUTEX_SPIN_SLOTS - 1))
+
+extern bool __kmp_spin_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid,
+                                  kmp_int32 gtid_code);
 extern int __kmp_acquire_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid);
 extern int __kmp_test_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid);
 extern int __kmp_release_futex_lock(kmp_futex_lock_t *lck, kmp_int32 gtid);
@@ -23,7 +23,7 @@
    Before we release this to a customer, please don't change this value.  After
    it is released and stable, then any new updates to the structures or data
    structure traversal algorithms need to change this value. */
-#define KMP_OMP_VERSION 9
+#define KMP_OMP_VERSION 10
 
 typedef struct {
   kmp_int32 offset;
@@ -224,6 +224,16 @@ typedef struct {
   offset_and_size_t hd_deque_tail;
   offset_and_size_t hd_deque_ntasks;
   offset_and_size_t hd_deque_last_stolen;
+  // Lock-free deque of the tasks pushed by the thread itself: it holds
+  // hd_lf_bottom - hd_lf_top tasks, at their index modulo da_size.
+  offset_and_size_t hd_lf_deque;
+  offset_and_size_t hd_lf_top;
+  offset_and_size_t hd_lf_bottom;
+
+  /* kmp_task_deque_array_t */
+  kmp_int32 da_sizeof_struct;
+  offset_and_size_t da_size;
+  offset_and_size_t da_tasks;
 
   // The last field of stable version.
   kmp_uint64 last_field;
@@ -316,7 +316,11 @@ extern "C" {
 #endif
 #endif /* CACHE_LINE */
 
+#if KMP_COMPILER_GCC || KMP_COMPILER_CLANG
+#define KMP_CACHE_PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#else
 #define KMP_CACHE_PREFETCH(ADDR) /* nothing */
+#endif
 
 // Define attribute that indicates that the fall through from the previous
 // case label is intentional and should not be diagnosed by a compiler
@@ -18,6 +18,7 @@
 #include "kmp_i18n.h"
 #include "kmp_io.h"
 #include "kmp_itt.h"
+#include "kmp_live_stats.h"
 #include "kmp_settings.h"
 #include "kmp_stats.h"
 #include "kmp_str.h"
@@ -970,6 +971,8 @@ static void __kmp_fork_team_threads(kmp_root_t *root, kmp_team_t *team,
   master_th->th.th_team_master = master_th;
   master_th->th.th_team_serialized = FALSE;
   master_th->th.th_dispatch = &team->t.t_dispatch[0];
+  if (team->t.t_victim_nproc != team->t.t_nproc)
+    __kmp_get_victim_hierarchy(team);
 
 /* make sure we are not the optimized hot team */
 #if KMP_NESTED_HOT_TEAMS
@@ -1437,6 +1440,7 @@ int __kmp_fork_call(ident_t *loc, int gtid,
     root = master_th->th.th_root;
     master_active = root->r.r_active;
     master_set_numthreads = master_th->th.th_set_nproc;
+    KMP_LIVE_STAT_INC(master_th, parallel);
 
 #if OMPT_SUPPORT
     ompt_data_t ompt_parallel_data = ompt_data_none;
@@ -3673,6 +3677,7 @@ int __kmp_register_root(int initial_thread) {
 #if USE_FAST_MEMORY
     __kmp_initialize_fast_memory(root_thread);
 #endif /* USE_FAST_MEMORY */
+    __kmp_live_stats_attach(root_thread, gtid);
 
 #if KMP_USE_BGET
     KMP_DEBUG_ASSERT(root_thread->th.th_local.bget_data == NULL);
@@ -4305,6 +4310,7 @@ kmp_info_t *__kmp_allocate_thread(kmp_root_t *root, kmp_team_t *team,
 #if USE_FAST_MEMORY
   __kmp_initialize_fast_memory(new_thr);
 #endif /* USE_FAST_MEMORY */
+  __kmp_live_stats_attach(new_thr, new_gtid);
 
 #if KMP_USE_BGET
   KMP_DEBUG_ASSERT(new_thr->th.th_local.bget_data == NULL);
@@ -4405,7 +4411,7 @@ static void __kmp_reinitialize_team(kmp_team_t *team,
   KMP_CHECK_UPDATE(team->t.t_id, KMP_GEN_TEAM_ID());
   // Copy ICVs to the master thread's implicit taskdata
   __kmp_init_implicit_task(loc, team->t.t_threads[0], team, 0, FALSE);
-  copy_icvs(&team->t.t_implicit_task_taskdata[0].td_icvs, new_icvs);
+  update_icvs(&team->t.t_implicit_task_taskdata[0].td_icvs, new_icvs);
 
   KF_TRACE(10, ("__kmp_reinitialize_team: exit this_thread=%p team=%p\n",
                 team->t.t_threads[0], team));
@@ -5860,6 +5866,7 @@ static void __kmp_reap_thread(kmp_info_t *thread, int is_root) {
 #if USE_FAST_MEMORY
   __kmp_free_fast_memory(thread);
 #endif /* USE_FAST_MEMORY */
+  __kmp_live_stats_detach(thread);
 
   __kmp_suspend_uninitialize_thread(thread);
 
@@ -6614,6 +6621,7 @@ static void __kmp_do_serial_initialize(void) {
   __kmp_global.g.g_dynamic_mode = dynamic_default;
 
   __kmp_env_initialize(NULL);
+  __kmp_live_stats_init();
 
 // Print all messages in message catalog for testing purposes.
 #ifdef KMP_DEBUG
@@ -7502,6 +7510,7 @@ void __kmp_cleanup(void) {
 #if KMP_STATS_ENABLED
   __kmp_stats_fini();
 #endif
+  __kmp_live_stats_fini();
 
   KA_TRACE(10, ("__kmp_cleanup: exit\n"));
 }
@@ -4621,6 +4621,19 @@ static void __kmp_stg_print_task_throttling(kmp_str_buf_t *buffer,
   __kmp_stg_print_bool(buffer, name, __kmp_enable_task_throttling);
 } // __kmp_stg_print_task_throttling
 
+// -----------------------------------------------------------------------------
+// KMP_LIVE_STATS
+
+static void __kmp_stg_parse_live_stats(char const *name, char const *value,
+                                       void *data) {
+  __kmp_stg_parse_bool(name, value, &__kmp_live_stats_export);
+} // __kmp_stg_parse_live_stats
+
+static void __kmp_stg_print_live_stats(kmp_str_buf_t *buffer, char const *name,
+                                       void *data) {
+  __kmp_stg_print_bool(buffer, name, __kmp_live_stats_export);
+} // __kmp_stg_print_live_stats
+
 // -----------------------------------------------------------------------------
 // OMP_DISPLAY_ENV
 
@@ -4924,6 +4937,8 @@ static kmp_setting_t __kmp_stg_table[] = {
 #endif
     {"KMP_ENABLE_TASK_THROTTLING", __kmp_stg_parse_task_throttling,
      __kmp_stg_print_task_throttling, NULL, 0, 0},
+    {"KMP_LIVE_STATS", __kmp_stg_parse_live_stats, __kmp_stg_print_live_stats,
+     NULL, 0, 0},
 
     {"OMP_DISPLAY_ENV", __kmp_stg_parse_omp_display_env,
      __kmp_stg_print_omp_display_env, NULL, 0, 0},
@@ -52,28 +52,23 @@ static inline kmp_depnode_t *__kmp_node_ref(kmp_depnode_t *node) {
   return node;
 }
 
-enum { KMP_DEPHASH_OTHER_SIZE = 97, KMP_DEPHASH_MASTER_SIZE = 997 };
-
-size_t sizes[] = { 997, 2003, 4001, 8191, 16001, 32003, 64007, 131071, 270029 };
-const size_t MAX_GEN = 8;
-
-static inline kmp_int32 __kmp_dephash_hash(kmp_intptr_t addr, size_t hsize) {
-  // TODO alternate to try: set = (((Addr64)(addrUsefulBits * 9.618)) %
-  // m_num_sets );
-  return ((addr >> 6) ^ (addr >> 2)) % hsize;
+// log2 of the initial number of slots of the dependence hash
+enum { KMP_DEPHASH_OTHER_BITS = 5, KMP_DEPHASH_MASTER_BITS = 9 };
+// Minimum number of entries of a chunk
+enum { KMP_DEPHASH_CHUNK_MIN = 16 };
+
+static inline size_t __kmp_dephash_hash(kmp_intptr_t addr, kmp_uint32 shift) {
+  // Fibonacci hashing: the top bits of the product depend on all the bits of
+  // the address, including the low ones that vary between array elements.
+  return (size_t)(((kmp_uint64)addr * 0x9E3779B97F4A7C15ULL) >> shift);
 }
 
-static kmp_dephash_t *__kmp_dephash_extend(kmp_info_t *thread,
-                                           kmp_dephash_t *current_dephash) {
+static kmp_dephash_t *__kmp_dephash_alloc(kmp_info_t *thread,
+                                          kmp_uint32 bits) {
   kmp_dephash_t *h;
-
-  size_t gen = current_dephash->generation + 1;
-  if (gen >= MAX_GEN)
-    return current_dephash;
-  size_t new_size = sizes[gen];
-
-  kmp_int32 size_to_allocate =
-      new_size * sizeof(kmp_dephash_entry_t *) + sizeof(kmp_dephash_t);
+  size_t h_size = (size_t)1 << bits;
+  size_t size_to_allocate =
+      h_size * sizeof(kmp_dephash_slot_t) + sizeof(kmp_dephash_t);
 
 #if USE_FAST_MEMORY
   h = (kmp_dephash_t *)__kmp_fast_allocate(thread, size_to_allocate);
@@ -81,25 +76,41 @@ static kmp_dephash_t *__kmp_dephash_extend(kmp_info_t *thread,
   h = (kmp_dephash_t *)__kmp_thread_malloc(thread, size_to_allocate);
 #endif
 
-  h->size = new_size;
+  h->size = h_size;
+  h->shift = 64 - bits;
+  h->nelements = 0;
+  h->chunks = NULL;
+  h->slots = (kmp_dephash_slot_t *)(h + 1);
+
+  for (size_t i = 0; i < h_size; i++)
+    h->slots[i].entry = NULL;
+
+  return h;
+}
+
+// Returns a table large enough for nnew more entries. Entries are not moved,
+// only the slots pointing to them are.
+static kmp_dephash_t *__kmp_dephash_extend(kmp_info_t *thread,
+                                           kmp_dephash_t *current_dephash,
+                                           size_t nnew) {
+  kmp_uint32 bits = 64 - current_dephash->shift;
+  size_t needed = (current_dephash->nelements + nnew) * 2;
+  while (((size_t)1 << bits) < needed)
+    bits++;
+
+  kmp_dephash_t *h = __kmp_dephash_alloc(thread, bits);
+  size_t mask = h->size - 1;
   h->nelements = current_dephash->nelements;
-  h->buckets = (kmp_dephash_entry **)(h + 1);
-  h->generation = gen;
-  h->nconflicts = 0;
+  h->chunks = current_dephash->chunks;
   // insert existing elements in the new table
   for (size_t i = 0; i < current_dephash->size; i++) {
-    kmp_dephash_entry_t *next, *entry;
-    for (entry = current_dephash->buckets[i]; entry; entry = next) {
-      next = entry->next_in_bucket;
-      // Compute the new hash using the new size, and insert the entry in
-      // the new bucket.
-      kmp_int32 new_bucket = __kmp_dephash_hash(entry->addr, h->size);
-      entry->next_in_bucket = h->buckets[new_bucket];
-      if (entry->next_in_bucket) {
-        h->nconflicts++;
-      }
-      h->buckets[new_bucket] = entry;
-    }
+    kmp_dephash_slot_t *slot = &current_dephash->slots[i];
+    if (slot->entry == NULL)
+      continue;
+    size_t j = __kmp_dephash_hash(slot->addr, h->shift);
+    while (h->slots[j].entry != NULL)
+      j = (j + 1) & mask;
+    h->slots[j] = *slot;
   }
 
   // Free old hash table
@@ -114,75 +125,75 @@ static kmp_dephash_t *__kmp_dephash_extend(kmp_info_t *thread,
 
 static kmp_dephash_t *__kmp_dephash_create(kmp_info_t *thread,
                                            kmp_taskdata_t *current_task) {
-  kmp_dephash_t *h;
-
-  size_t h_size;
-
   if (current_task->td_flags.tasktype == TASK_IMPLICIT)
-    h_size = KMP_DEPHASH_MASTER_SIZE;
+    return __kmp_dephash_alloc(thread, KMP_DEPHASH_MASTER_BITS);
   else
-    h_size = KMP_DEPHASH_OTHER_SIZE;
+    return __kmp_dephash_alloc(thread, KMP_DEPHASH_OTHER_BITS);
+}
 
-  kmp_int32 size =
-      h_size * sizeof(kmp_dephash_entry_t *) + sizeof(kmp_dephash_t);
+// Makes room for ndeps more entries, so that the dependences of a task are
+// all looked up in the same table. Linear probing sequences stay short as
+// long as at most half of the slots are used.
+static inline void __kmp_dephash_reserve(kmp_info_t *thread,
+                                         kmp_dephash_t **hash, size_t ndeps) {
+  kmp_dephash_t *h = *hash;
+  if ((h->nelements + ndeps) * 2 > h->size)
+    *hash = __kmp_dephash_extend(thread, h, ndeps);
+}
 
+static kmp_dephash_entry_t *__kmp_dephash_new_entry(kmp_info_t *thread,
+                                                    kmp_dephash_t *h) {
+  kmp_dephash_chunk_t *chunk = h->chunks;
+  if (chunk == NULL || chunk->nused == chunk->size) {
+    // Chunks grow with the table so that there are few of them
+    kmp_uint32 n = KMP_MAX(h->nelements, (kmp_uint32)KMP_DEPHASH_CHUNK_MIN);
+    size_t size = sizeof(kmp_dephash_chunk_t) + n * sizeof(kmp_dephash_entry_t);
 #if USE_FAST_MEMORY
-  h = (kmp_dephash_t *)__kmp_fast_allocate(thread, size);
+    chunk = (kmp_dephash_chunk_t *)__kmp_fast_allocate(thread, size);
 #else
-  h = (kmp_dephash_t *)__kmp_thread_malloc(thread, size);
+    chunk = (kmp_dephash_chunk_t *)__kmp_thread_malloc(thread, size);
 #endif
-  h->size = h_size;
-
-  h->generation = 0;
-  h->nelements = 0;
-  h->nconflicts = 0;
-  h->buckets = (kmp_dephash_entry **)(h + 1);
-
-  for (size_t i = 0; i < h_size; i++)
-    h->buckets[i] = 0;
-
-  return h;
+    chunk->next = h->chunks;
+    chunk->size = n;
+    chunk->nused = 0;
+    h->chunks = chunk;
+  }
+  return (kmp_dephash_entry_t *)(chunk + 1) + chunk->nused++;
 }
 
 #define ENTRY_LAST_INS 0
 #define ENTRY_LAST_MTXS 1
 
+// The table must have room for the entry, see __kmp_dephash_reserve.
+// Dependences are matched on their base address only: the list items in the
+// depend clauses of sibling tasks must designate identical or disjoint
+// storage, so partially overlapping address ranges never need to be matched.
 static kmp_dephash_entry *
-__kmp_dephash_find(kmp_info_t *thread, kmp_dephash_t **hash, kmp_intptr_t addr) {
-  kmp_dephash_t *h = *hash;
-  if (h->nelements != 0
-      && h->nconflicts/h->size >= 1) {
-    *hash = __kmp_dephash_extend(thread, h);
-    h = *hash;
-  }
-  kmp_int32 bucket = __kmp_dephash_hash(addr, h->size);
-
-  kmp_dephash_entry_t *entry;
-  for (entry = h->buckets[bucket]; entry; entry = entry->next_in_bucket)
-    if (entry->addr == addr)
+__kmp_dephash_find(kmp_info_t *thread, kmp_dephash_t *h, kmp_intptr_t addr) {
+  size_t mask = h->size - 1;
+  size_t i = __kmp_dephash_hash(addr, h->shift);
+  kmp_dephash_slot_t *slot;
+
+  for (;; i = (i + 1) & mask) {
+    slot = &h->slots[i];
+    if (slot->entry == NULL)
       break;
-
-  if (entry == NULL) {
-// create entry. This is only done by one thread so no locking required
-#if USE_FAST_MEMORY
-    entry = (kmp_dephash_entry_t *)__kmp_fast_allocate(
-        thread, sizeof(kmp_dephash_entry_t));
-#else
-    entry = (kmp_dephash_entry_t *)__kmp_thread_malloc(
-        thread, sizeof(kmp_dephash_entry_t));
-#endif
-    entry->addr = addr;
-    entry->last_out = NULL;
-    entry->last_ins = NULL;
-    entry->last_mtxs = NULL;
-    entry->last_flag = ENTRY_LAST_INS;
-    entry->mtx_lock = NULL;
-    entry->next_in_bucket = h->buckets[bucket];
-    h->buckets[bucket] = entry;
-    h->nelements++;
-    if (entry->next_in_bucket)
-      h->nconflicts++;
+    if (slot->addr == addr)
+      return slot->entry;
   }
+
+  KMP_DEBUG_ASSERT((h->nelements + 1) * 2 <= h->size);
+  // create entry. This is only done by one thread so no locking required
+  kmp_dephash_entry_t *entry = __kmp_dephash_new_entry(thread, h);
+  entry->addr = addr;
+  entry->last_out = NULL;
+  entry->last_ins = NULL;
+  entry->last_mtxs = NULL;
+  entry->last_flag = ENTRY_LAST_INS;
+  entry->mtx_lock = NULL;
+  slot->addr = addr;
+  slot->entry = entry;
+  h->nelements++;
   return entry;
 }
 
@@ -290,7 +301,7 @@ static inline kmp_int32 __kmp_depnode_link_successor(kmp_int32 gtid,
 
 template <bool filter>
 static inline kmp_int32
-__kmp_process_deps(kmp_int32 gtid, kmp_depnode_t *node, kmp_dephash_t **hash,
+__kmp_process_deps(kmp_int32 gtid, kmp_depnode_t *node, kmp_dephash_t *hash,
                    bool dep_barrier, kmp_int32 ndeps,
                    kmp_depend_info_t *dep_list, kmp_task_t *task) {
   KA_TRACE(30, ("__kmp_process_deps<%d>: T#%d processing %d dependencies : "
@@ -302,6 +313,10 @@ __kmp_process_deps(kmp_int32 gtid, kmp_depnode_t *node, kmp_dephash_t **hash,
   for (kmp_int32 i = 0; i < ndeps; i++) {
     const kmp_depend_info_t *dep = &dep_list[i];
 
+    if (i + 1 < ndeps)
+      KMP_CACHE_PREFETCH(&hash->slots[__kmp_dephash_hash(
+          dep_list[i + 1].base_addr, hash->shift)]);
+
     if (filter && dep->base_addr == 0)
       continue; // skip filtered entries
 
@@ -408,6 +423,27 @@ __kmp_process_deps(kmp_int32 gtid, kmp_depnode_t *node, kmp_dephash_t **hash,
 #define NO_DEP_BARRIER (false)
 #define DEP_BARRIER (true)
 
+// Lists longer than this are sorted to find duplicate dependences, instead of
+// comparing all pairs. Iterators in depend clauses generate such lists.
+#define KMP_DEPS_SORT_THRESHOLD 16
+
+// Merges the flags of a duplicate dependence into the first one and marks the
+// duplicate as void
+static inline void __kmp_merge_dep(kmp_depend_info_t *dep,
+                                   kmp_depend_info_t *dup) {
+  dep->flags.in |= dup->flags.in;
+  dep->flags.out |= (dup->flags.out || (dep->flags.in && dup->flags.mtx) ||
+                     (dep->flags.mtx && dup->flags.in));
+  dep->flags.mtx = dep->flags.mtx | dup->flags.mtx && !dep->flags.out;
+  dup->base_addr = 0;
+}
+
+static int __kmp_dep_cmp(const void *a, const void *b) {
+  kmp_intptr_t addr_a = ((const kmp_depend_info_t *)a)->base_addr;
+  kmp_intptr_t addr_b = ((const kmp_depend_info_t *)b)->base_addr;
+  return addr_a < addr_b ? -1 : addr_a > addr_b;
+}
+
 // returns true if the task has any outstanding dependence
 static bool __kmp_check_deps(kmp_int32 gtid, kmp_depnode_t *node,
                              kmp_task_t *task, kmp_dephash_t **hash,
@@ -415,7 +451,7 @@ static bool __kmp_check_deps(kmp_int32 gtid, kmp_depnode_t *node,
                              kmp_depend_info_t *dep_list,
                              kmp_int32 ndeps_noalias,
                              kmp_depend_info_t *noalias_dep_list) {
-  int i, n_mtxs = 0;
+  int i, j, n_mtxs = 0;
 #if KMP_DEBUG
   kmp_taskdata_t *taskdata = KMP_TASK_TO_TASKDATA(task);
 #endif
@@ -425,20 +461,23 @@ static bool __kmp_check_deps(kmp_int32 gtid, kmp_depnode_t *node,
                 gtid, taskdata, ndeps, ndeps_noalias, dep_barrier));
 
   // Filter deps in dep_list
-  // TODO: Different algorithm for large dep_list ( > 10 ? )
+  bool sorted = ndeps > KMP_DEPS_SORT_THRESHOLD;
+  if (sorted) {
+    qsort(dep_list, ndeps, sizeof(*dep_list), __kmp_dep_cmp);
+    for (i = 1, j = 0; i < ndeps; i++) {
+      if (dep_list[i].base_addr != 0 &&
+          dep_list[i].base_addr == dep_list[j].base_addr)
+        __kmp_merge_dep(&dep_list[j], &dep_list[i]);
+      else
+        j = i;
+    }
+  }
   for (i = 0; i < ndeps; i++) {
     if (dep_list[i].base_addr != 0) {
-      for (int j = i + 1; j < ndeps; j++) {
-        if (dep_list[i].base_addr == dep_list[j].base_addr) {
-          dep_list[i].flags.in |= dep_list[j].flags.in;
-          dep_list[i].flags.out |=
-              (dep_list[j].flags.out ||
-               (dep_list[i].flags.in && dep_list[j].flags.mtx) ||
-               (dep_list[i].flags.mtx && dep_list[j].flags.in));
-          dep_list[i].flags.mtx =
-              dep_list[i].flags.mtx | dep_list[j].flags.mtx &&
-              !dep_list[i].flags.out;
-          dep_list[j].base_addr = 0; // Mark j element as void
+      if (!sorted) {
+        for (j = i + 1; j < ndeps; j++) {
+          if (dep_list[i].base_addr == dep_list[j].base_addr)
+            __kmp_merge_dep(&dep_list[i], &dep_list[j]);
         }
       }
       if (dep_list[i].flags.mtx) {
@@ -464,10 +503,11 @@ static bool __kmp_check_deps(kmp_int32 gtid, kmp_depnode_t *node,
   // the end
   int npredecessors;
 
-  npredecessors = __kmp_process_deps<true>(gtid, node, hash, dep_barrier, ndeps,
-                                           dep_list, task);
+  __kmp_dephash_reserve(__kmp_threads[gtid], hash, ndeps + ndeps_noalias);
+  npredecessors = __kmp_process_deps<true>(gtid, node, *hash, dep_barrier,
+                                           ndeps, dep_list, task);
   npredecessors += __kmp_process_deps<false>(
-      gtid, node, hash, dep_barrier, ndeps_noalias, noalias_dep_list, task);
+      gtid, node, *hash, dep_barrier, ndeps_noalias, noalias_dep_list, task);
 
   node->dn.task = task;
   KMP_MB();
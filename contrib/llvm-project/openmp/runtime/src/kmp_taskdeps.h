@@ -53,26 +53,31 @@ static inline void __kmp_depnode_list_free(kmp_info_t *thread,
 
 static inline void __kmp_dephash_free_entries(kmp_info_t *thread,
                                               kmp_dephash_t *h) {
-  for (size_t i = 0; i < h->size; i++) {
-    if (h->buckets[i]) {
-      kmp_dephash_entry_t *next;
-      for (kmp_dephash_entry_t *entry = h->buckets[i]; entry; entry = next) {
-        next = entry->next_in_bucket;
-        __kmp_depnode_list_free(thread, entry->last_ins);
-        __kmp_depnode_list_free(thread, entry->last_mtxs);
-        __kmp_node_deref(thread, entry->last_out);
-        if (entry->mtx_lock) {
-          __kmp_destroy_lock(entry->mtx_lock);
-          __kmp_free(entry->mtx_lock);
-        }
+  kmp_dephash_chunk_t *next;
+  for (kmp_dephash_chunk_t *chunk = h->chunks; chunk; chunk = next) {
+    next = chunk->next;
+    kmp_dephash_entry_t *entries = (kmp_dephash_entry_t *)(chunk + 1);
+    for (kmp_uint32 i = 0; i < chunk->nused; i++) {
+      kmp_dephash_entry_t *entry = &entries[i];
+      __kmp_depnode_list_free(thread, entry->last_ins);
+      __kmp_depnode_list_free(thread, entry->last_mtxs);
+      __kmp_node_deref(thread, entry->last_out);
+      if (entry->mtx_lock) {
+        __kmp_destroy_lock(entry->mtx_lock);
+        __kmp_free(entry->mtx_lock);
+      }
+    }
 #if USE_FAST_MEMORY
-        __kmp_fast_free(thread, entry);
+    __kmp_fast_free(thread, chunk);
 #else
-        __kmp_thread_free(thread, entry);
+    __kmp_thread_free(thread, chunk);
 #endif
-      }
-      h->buckets[i] = 0;
-    }
+  }
+  h->chunks = NULL;
+  if (h->nelements) {
+    for (size_t i = 0; i < h->size; i++)
+      h->slots[i].entry = NULL;
+    h->nelements = 0;
   }
 }
 
@@ -13,6 +13,7 @@
 #include "kmp.h"
 #include "kmp_i18n.h"
 #include "kmp_itt.h"
+#include "kmp_live_stats.h"
 #include "kmp_stats.h"
 #include "kmp_wait_release.h"
 #include "kmp_taskdeps.h"
@@ -321,6 +322,161 @@ static void __kmp_realloc_task_deque(kmp_info_t *thread,
   thread_data->td.td_deque_size = new_size;
 }
 
+// __kmp_alloc_lf_deque_array:
+// Allocates an empty array for a lock-free task deque, with size slots.
+static kmp_task_deque_array_t *__kmp_alloc_lf_deque_array(kmp_int32 size) {
+  kmp_task_deque_array_t *array = (kmp_task_deque_array_t *)__kmp_allocate(
+      sizeof(kmp_task_deque_array_t) +
+      size * sizeof(std::atomic<kmp_taskdata_t *>));
+  array->tda_size = size;
+  array->tda_tasks = (std::atomic<kmp_taskdata_t *> *)(array + 1);
+  return array;
+}
+
+// __kmp_lf_deque_ntasks:
+// Returns the number of tasks in the lock-free deque of a thread. Unless the
+// caller owns the deque, the result may be stale.
+static inline kmp_int32 __kmp_lf_deque_ntasks(kmp_thread_data_t *thread_data) {
+  kmp_int64 top = thread_data->td.td_lf_top.load(std::memory_order_acquire);
+  kmp_int64 bottom =
+      thread_data->td.td_lf_bottom.load(std::memory_order_acquire);
+  return bottom > top ? (kmp_int32)(bottom - top) : 0;
+}
+
+// __kmp_grow_lf_deque:
+// Replaces the array of the lock-free deque of the calling thread by one twice
+// as large, holding the tasks between top and bottom. Thieves may keep reading
+// the previous array, which is only freed along with the deque.
+static kmp_task_deque_array_t *
+__kmp_grow_lf_deque(kmp_info_t *thread, kmp_thread_data_t *thread_data,
+                    kmp_int64 top, kmp_int64 bottom) {
+  kmp_task_deque_array_t *array =
+      thread_data->td.td_lf_deque.load(std::memory_order_relaxed);
+  kmp_task_deque_array_t *new_array =
+      __kmp_alloc_lf_deque_array(2 * array->tda_size);
+
+  KE_TRACE(10, ("__kmp_grow_lf_deque: T#%d growing deque[from %d to %d] for "
+                "thread_data %p\n",
+                __kmp_gtid_from_thread(thread), array->tda_size,
+                new_array->tda_size, thread_data));
+
+  for (kmp_int64 i = top; i < bottom; ++i)
+    new_array->tda_tasks[i & (new_array->tda_size - 1)].store(
+        array->tda_tasks[i & (array->tda_size - 1)].load(
+            std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  new_array->tda_prev = array;
+  thread_data->td.td_lf_deque.store(new_array, std::memory_order_release);
+  return new_array;
+}
+
+// __kmp_lf_deque_put:
+// Stores a task at the bottom of the lock-free deque of the calling thread,
+// which must have room for it.
+static inline void __kmp_lf_deque_put(kmp_thread_data_t *thread_data,
+                                      kmp_taskdata_t *taskdata) {
+  kmp_int64 bottom =
+      thread_data->td.td_lf_bottom.load(std::memory_order_relaxed);
+  kmp_task_deque_array_t *array =
+      thread_data->td.td_lf_deque.load(std::memory_order_relaxed);
+  KMP_DEBUG_ASSERT(bottom -
+                       thread_data->td.td_lf_top.load(
+                           std::memory_order_relaxed) <
+                   array->tda_size);
+  array->tda_tasks[bottom & (array->tda_size - 1)].store(
+      taskdata, std::memory_order_relaxed);
+  // Publish the task to thieves, which read the bottom index first.
+  thread_data->td.td_lf_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+// __kmp_lf_deque_pop:
+// Takes the task at the bottom of the lock-free deque of the calling thread.
+// The owner only races with thieves for the last task of the deque.
+static kmp_taskdata_t *__kmp_lf_deque_pop(kmp_thread_data_t *thread_data) {
+  kmp_int64 bottom =
+      thread_data->td.td_lf_bottom.load(std::memory_order_relaxed) - 1;
+  kmp_task_deque_array_t *array =
+      thread_data->td.td_lf_deque.load(std::memory_order_relaxed);
+  thread_data->td.td_lf_bottom.store(bottom, std::memory_order_relaxed);
+  // Either a thief sees the lowered bottom index, or we see its raised top
+  // index.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  kmp_int64 top = thread_data->td.td_lf_top.load(std::memory_order_relaxed);
+  kmp_taskdata_t *taskdata = NULL;
+  if (top <= bottom) {
+    taskdata = array->tda_tasks[bottom & (array->tda_size - 1)].load(
+        std::memory_order_relaxed);
+    if (top < bottom)
+      return taskdata;
+    // This is the last task: claim it the way thieves do.
+    if (!thread_data->td.td_lf_top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst,
+            std::memory_order_relaxed))
+      taskdata = NULL;
+  }
+  thread_data->td.td_lf_bottom.store(bottom + 1, std::memory_order_relaxed);
+  return taskdata;
+}
+
+// __kmp_lf_deque_steal:
+// Takes the task at the top of the lock-free deque of another thread. Returns
+// NULL if the deque is empty or if another thread took the task first. As the
+// task may be executed and freed by whoever takes it, it must not be looked at
+// before it is taken, so the caller checks the TSC afterwards.
+static kmp_taskdata_t *
+__kmp_lf_deque_steal(kmp_int32 gtid, kmp_thread_data_t *victim_td,
+                     kmp_task_team_t *task_team,
+                     std::atomic<kmp_int32> *unfinished_threads,
+                     int *thread_finished) {
+  kmp_int64 top = victim_td->td.td_lf_top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  kmp_int64 bottom = victim_td->td.td_lf_bottom.load(std::memory_order_acquire);
+  if (top >= bottom)
+    return NULL;
+  kmp_task_deque_array_t *array =
+      victim_td->td.td_lf_deque.load(std::memory_order_acquire);
+  kmp_taskdata_t *taskdata = array->tda_tasks[top & (array->tda_size - 1)].load(
+      std::memory_order_relaxed);
+  // As in __kmp_steal_task, a finished thread must be un-marked before the
+  // task leaves the deque.
+  if (*thread_finished)
+    KMP_ATOMIC_INC(unfinished_threads);
+  if (!victim_td->td.td_lf_top.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst,
+          std::memory_order_relaxed)) {
+    if (*thread_finished)
+      KMP_ATOMIC_DEC(unfinished_threads);
+    return NULL;
+  }
+  if (*thread_finished) {
+    KA_TRACE(20, ("__kmp_lf_deque_steal: T#%d inc unfinished_threads: "
+                  "task_team=%p\n",
+                  gtid, task_team));
+    *thread_finished = FALSE;
+  }
+  return taskdata;
+}
+
+// __kmp_give_back_task:
+// Puts a task taken from the lock-free deque of a thread, which the caller
+// may not execute, at the head of the locked deque of that thread, where the
+// owner and other thieves can still find it.
+static void __kmp_give_back_task(kmp_info_t *thread,
+                                 kmp_thread_data_t *thread_data,
+                                 kmp_taskdata_t *taskdata) {
+  __kmp_acquire_bootstrap_lock(&thread_data->td.td_deque_lock);
+  if (TCR_4(thread_data->td.td_deque_ntasks) >=
+      TASK_DEQUE_SIZE(thread_data->td)) {
+    __kmp_realloc_task_deque(thread, thread_data);
+  }
+  thread_data->td.td_deque_head =
+      (thread_data->td.td_deque_head - 1) & TASK_DEQUE_MASK(thread_data->td);
+  thread_data->td.td_deque[thread_data->td.td_deque_head] = taskdata;
+  TCW_4(thread_data->td.td_deque_ntasks,
+        TCR_4(thread_data->td.td_deque_ntasks) + 1);
+  __kmp_release_bootstrap_lock(&thread_data->td.td_deque_lock);
+}
+
 //  __kmp_push_task: Add a task to the thread's deque
 static kmp_int32 __kmp_push_task(kmp_int32 gtid, kmp_task_t *task) {
   kmp_info_t *thread = __kmp_threads[gtid];
@@ -368,10 +524,13 @@ static kmp_int32 __kmp_push_task(kmp_int32 gtid, kmp_task_t *task) {
     __kmp_alloc_task_deque(thread, thread_data);
   }
 
-  int locked = 0;
+  // Only the calling thread pushes to its lock-free deque, so no lock is needed
+  kmp_int64 top = thread_data->td.td_lf_top.load(std::memory_order_acquire);
+  kmp_int64 bottom =
+      thread_data->td.td_lf_bottom.load(std::memory_order_relaxed);
   // Check if deque is full
-  if (TCR_4(thread_data->td.td_deque_ntasks) >=
-      TASK_DEQUE_SIZE(thread_data->td)) {
+  if (bottom - top >=
+      thread_data->td.td_lf_deque.load(std::memory_order_relaxed)->tda_size) {
     if (__kmp_enable_task_throttling &&
         __kmp_task_is_allowed(gtid, __kmp_task_stealing_constraint, taskdata,
                               thread->th.th_current_task)) {
@@ -379,54 +538,15 @@ static kmp_int32 __kmp_push_task(kmp_int32 gtid, kmp_task_t *task) {
                     "TASK_NOT_PUSHED for task %p\n",
                     gtid, taskdata));
       return TASK_NOT_PUSHED;
-    } else {
-      __kmp_acquire_bootstrap_lock(&thread_data->td.td_deque_lock);
-      locked = 1;
-      if (TCR_4(thread_data->td.td_deque_ntasks) >=
-          TASK_DEQUE_SIZE(thread_data->td)) {
-        // expand deque to push the task which is not allowed to execute
-        __kmp_realloc_task_deque(thread, thread_data);
-      }
-    }
-  }
-  // Lock the deque for the task push operation
-  if (!locked) {
-    __kmp_acquire_bootstrap_lock(&thread_data->td.td_deque_lock);
-    // Need to recheck as we can get a proxy task from thread outside of OpenMP
-    if (TCR_4(thread_data->td.td_deque_ntasks) >=
-        TASK_DEQUE_SIZE(thread_data->td)) {
-      if (__kmp_enable_task_throttling &&
-          __kmp_task_is_allowed(gtid, __kmp_task_stealing_constraint, taskdata,
-                                thread->th.th_current_task)) {
-        __kmp_release_bootstrap_lock(&thread_data->td.td_deque_lock);
-        KA_TRACE(20, ("__kmp_push_task: T#%d deque is full on 2nd check; "
-                      "returning TASK_NOT_PUSHED for task %p\n",
-                      gtid, taskdata));
-        return TASK_NOT_PUSHED;
-      } else {
-        // expand deque to push the task which is not allowed to execute
-        __kmp_realloc_task_deque(thread, thread_data);
-      }
     }
+    // expand deque to push the task which is not allowed to execute
+    __kmp_grow_lf_deque(thread, thread_data, top, bottom);
   }
-  // Must have room since no thread can add tasks but calling thread
-  KMP_DEBUG_ASSERT(TCR_4(thread_data->td.td_deque_ntasks) <
-                   TASK_DEQUE_SIZE(thread_data->td));
-
-  thread_data->td.td_deque[thread_data->td.td_deque_tail] =
-      taskdata; // Push taskdata
-  // Wrap index.
-  thread_data->td.td_deque_tail =
-      (thread_data->td.td_deque_tail + 1) & TASK_DEQUE_MASK(thread_data->td);
-  TCW_4(thread_data->td.td_deque_ntasks,
-        TCR_4(thread_data->td.td_deque_ntasks) + 1); // Adjust task count
+  __kmp_lf_deque_put(thread_data, taskdata);
 
   KA_TRACE(20, ("__kmp_push_task: T#%d returning TASK_SUCCESSFULLY_PUSHED: "
-                "task=%p ntasks=%d head=%u tail=%u\n",
-                gtid, taskdata, thread_data->td.td_deque_ntasks,
-                thread_data->td.td_deque_head, thread_data->td.td_deque_tail));
-
-  __kmp_release_bootstrap_lock(&thread_data->td.td_deque_lock);
+                "task=%p top=%lld bottom=%lld\n",
+                gtid, taskdata, (long long)top, (long long)bottom + 1));
 
   return TASK_SUCCESSFULLY_PUSHED;
 }
@@ -1062,32 +1182,37 @@ void __kmp_init_implicit_task(ident_t *loc_ref, kmp_info_t *this_thr,
       ("__kmp_init_implicit_task(enter): T#:%d team=%p task=%p, reinit=%s\n",
        tid, team, task, set_curr_task ? "TRUE" : "FALSE"));
 
-  task->td_task_id = KMP_GEN_TASK_ID();
-  task->td_team = team;
+  // For hot teams this runs at every fork, mostly from the thread releasing
+  // this one in the fork barrier: only write fields that changed, so that the
+  // cache line of the implicit task is not taken away from its thread.
+  KMP_CHECK_UPDATE(task->td_task_id, KMP_GEN_TASK_ID());
+  KMP_CHECK_UPDATE(task->td_team, team);
   //    task->td_parent   = NULL;  // fix for CQ230101 (broken parent task info
   //    in debugger)
-  task->td_ident = loc_ref;
-  task->td_taskwait_ident = NULL;
-  task->td_taskwait_counter = 0;
-  task->td_taskwait_thread = 0;
+  KMP_CHECK_UPDATE(task->td_ident, loc_ref);
+  KMP_CHECK_UPDATE(task->td_taskwait_ident, NULL);
+  KMP_CHECK_UPDATE(task->td_taskwait_counter, 0);
+  KMP_CHECK_UPDATE(task->td_taskwait_thread, 0);
 
-  task->td_flags.tiedness = TASK_TIED;
-  task->td_flags.tasktype = TASK_IMPLICIT;
-  task->td_flags.proxy = TASK_FULL;
+  KMP_CHECK_UPDATE(task->td_flags.tiedness, TASK_TIED);
+  KMP_CHECK_UPDATE(task->td_flags.tasktype, TASK_IMPLICIT);
+  KMP_CHECK_UPDATE(task->td_flags.proxy, TASK_FULL);
 
   // All implicit tasks are executed immediately, not deferred
-  task->td_flags.task_serial = 1;
-  task->td_flags.tasking_ser = (__kmp_tasking_mode == tskm_immediate_exec);
-  task->td_flags.team_serial = (team->t.t_serialized) ? 1 : 0;
+  KMP_CHECK_UPDATE(task->td_flags.task_serial, 1);
+  KMP_CHECK_UPDATE(task->td_flags.tasking_ser,
+                   (__kmp_tasking_mode == tskm_immediate_exec));
+  KMP_CHECK_UPDATE(task->td_flags.team_serial, (team->t.t_serialized) ? 1 : 0);
 
-  task->td_flags.started = 1;
-  task->td_flags.executing = 1;
-  task->td_flags.complete = 0;
-  task->td_flags.freed = 0;
+  KMP_CHECK_UPDATE(task->td_flags.started, 1);
+  KMP_CHECK_UPDATE(task->td_flags.executing, 1);
+  KMP_CHECK_UPDATE(task->td_flags.complete, 0);
+  KMP_CHECK_UPDATE(task->td_flags.freed, 0);
 
-  task->td_depnode = NULL;
-  task->td_last_tied = task;
-  task->td_allow_completion_event.type = KMP_EVENT_UNINITIALIZED;
+  KMP_CHECK_UPDATE(task->td_depnode, NULL);
+  KMP_CHECK_UPDATE(task->td_last_tied, task);
+  KMP_CHECK_UPDATE(task->td_allow_completion_event.type,
+                   KMP_EVENT_UNINITIALIZED);
 
   if (set_curr_task) { // only do this init first time thread is created
     KMP_ATOMIC_ST_REL(&task->td_incomplete_child_tasks, 0);
@@ -1429,13 +1554,11 @@ __kmpc_omp_reg_task_with_affinity(ident_t *loc_ref, kmp_int32 gtid,
   return 0;
 }
 
-//  __kmp_invoke_task: invoke the specified task
-//
-// gtid: global thread ID of caller
-// task: the task to invoke
-// current_task: the task to resume after task invocation
-static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
-                              kmp_taskdata_t *current_task) {
+// template<ompt>: effectively ompt_enabled.enabled!=0, checked once by
+// __kmp_invoke_task rather than at every OMPT hook of the task execution
+template <bool ompt>
+static void __kmp_invoke_task_template(kmp_int32 gtid, kmp_task_t *task,
+                                       kmp_taskdata_t *current_task) {
   kmp_taskdata_t *taskdata = KMP_TASK_TO_TASKDATA(task);
   kmp_info_t *thread;
   int discard = 0 /* false */;
@@ -1465,7 +1588,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
   // For untied tasks, the first task executed only calls __kmpc_omp_task and
   // does not execute code.
   ompt_thread_info_t oldInfo;
-  if (UNLIKELY(ompt_enabled.enabled)) {
+  if (ompt) {
     // Store the threads states and restore them after the task
     thread = __kmp_threads[gtid];
     oldInfo = thread->th.ompt_thread_info;
@@ -1482,6 +1605,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
     ANNOTATE_HAPPENS_AFTER(task);
     __kmp_task_start(gtid, task, current_task); // OMPT only if not discarded
   }
+  KMP_LIVE_STAT_INC(__kmp_threads[gtid], task_executed);
 
   // TODO: cancel tasks if the parallel region has also been cancelled
   // TODO: check if this sequence can be hoisted above __kmp_task_start
@@ -1494,7 +1618,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
         (this_team->t.t_cancel_request == cancel_parallel)) {
 #if OMPT_SUPPORT && OMPT_OPTIONAL
       ompt_data_t *task_data;
-      if (UNLIKELY(ompt_enabled.ompt_callback_cancel)) {
+      if (ompt && ompt_enabled.ompt_callback_cancel) {
         __ompt_get_task_info_internal(0, NULL, &task_data, NULL, NULL, NULL);
         ompt_callbacks.ompt_callback(ompt_callback_cancel)(
             task_data,
@@ -1543,7 +1667,7 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
 
 // OMPT task begin
 #if OMPT_SUPPORT
-    if (UNLIKELY(ompt_enabled.enabled))
+    if (ompt)
       __ompt_task_start(task, current_task, gtid);
 #endif
 
@@ -1586,15 +1710,14 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
   if (taskdata->td_flags.proxy != TASK_PROXY) {
     ANNOTATE_HAPPENS_BEFORE(taskdata->td_parent);
 #if OMPT_SUPPORT
-    if (UNLIKELY(ompt_enabled.enabled)) {
+    if (ompt) {
       thread->th.ompt_thread_info = oldInfo;
       if (taskdata->td_flags.tiedness == TASK_TIED) {
         taskdata->ompt_task_info.frame.exit_frame = ompt_data_none;
       }
-      __kmp_task_finish<true>(gtid, task, current_task);
-    } else
+    }
 #endif
-      __kmp_task_finish<false>(gtid, task, current_task);
+    __kmp_task_finish<ompt>(gtid, task, current_task);
   }
 
   KA_TRACE(
@@ -1604,6 +1727,30 @@ static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
   return;
 }
 
+#if OMPT_SUPPORT
+OMPT_NOINLINE
+static void __kmp_invoke_task_ompt(kmp_int32 gtid, kmp_task_t *task,
+                                   kmp_taskdata_t *current_task) {
+  __kmp_invoke_task_template<true>(gtid, task, current_task);
+}
+#endif // OMPT_SUPPORT
+
+//  __kmp_invoke_task: invoke the specified task
+//
+// gtid: global thread ID of caller
+// task: the task to invoke
+// current_task: the task to resume after task invocation
+static void __kmp_invoke_task(kmp_int32 gtid, kmp_task_t *task,
+                              kmp_taskdata_t *current_task) {
+#if OMPT_SUPPORT
+  if (UNLIKELY(ompt_enabled.enabled)) {
+    __kmp_invoke_task_ompt(gtid, task, current_task);
+    return;
+  }
+#endif
+  __kmp_invoke_task_template<false>(gtid, task, current_task);
+}
+
 // __kmpc_omp_task_parts: Schedule a thread-switchable task for execution
 //
 // loc_ref: location of original task pragma (ignored)
@@ -2609,6 +2756,25 @@ static kmp_task_t *__kmp_remove_my_task(kmp_info_t *thread, kmp_int32 gtid,
                 gtid, thread_data->td.td_deque_ntasks,
                 thread_data->td.td_deque_head, thread_data->td.td_deque_tail));
 
+  // Tasks pushed by this thread come first, without locking
+  if (__kmp_lf_deque_ntasks(thread_data) != 0) {
+    taskdata = __kmp_lf_deque_pop(thread_data);
+    if (taskdata != NULL) {
+      if (__kmp_task_is_allowed(gtid, is_constrained, taskdata,
+                                thread->th.th_current_task)) {
+        KA_TRACE(10, ("__kmp_remove_my_task(exit #6): T#%d task %p removed "
+                      "from lock-free deque\n",
+                      gtid, taskdata));
+        return KMP_TASKDATA_TO_TASK(taskdata);
+      }
+      // The TSC does not allow to execute the task, put it back and look at
+      // the tasks given to this thread instead
+      __kmp_lf_deque_put(thread_data, taskdata);
+      KA_TRACE(10, ("__kmp_remove_my_task: T#%d TSC blocks bottom task %p\n",
+                    gtid, taskdata));
+    }
+  }
+
   if (TCR_4(thread_data->td.td_deque_ntasks) == 0) {
     KA_TRACE(10,
              ("__kmp_remove_my_task(exit #1): T#%d No tasks to remove: "
@@ -2689,6 +2855,24 @@ static kmp_task_t *__kmp_steal_task(kmp_info_t *victim_thr, kmp_int32 gtid,
                 victim_td->td.td_deque_ntasks, victim_td->td.td_deque_head,
                 victim_td->td.td_deque_tail));
 
+  current = __kmp_threads[gtid]->th.th_current_task;
+  // Try the lock-free deque of the victim first. The task is taken before it
+  // is checked against the TSC; if it may not be executed here, it goes to the
+  // locked deque of the victim, which is tried next.
+  taskdata = __kmp_lf_deque_steal(gtid, victim_td, task_team,
+                                  unfinished_threads, thread_finished);
+  if (taskdata != NULL) {
+    if (__kmp_task_is_allowed(gtid, is_constrained, taskdata, current)) {
+      KMP_COUNT_BLOCK(TASK_stolen);
+      KA_TRACE(10, ("__kmp_steal_task(exit #6): T#%d stole task %p from T#%d "
+                    "lock-free deque: task_team=%p\n",
+                    gtid, taskdata, __kmp_gtid_from_thread(victim_thr),
+                    task_team));
+      return KMP_TASKDATA_TO_TASK(taskdata);
+    }
+    __kmp_give_back_task(victim_thr, victim_td, taskdata);
+  }
+
   if (TCR_4(victim_td->td.td_deque_ntasks) == 0) {
     KA_TRACE(10, ("__kmp_steal_task(exit #1): T#%d could not steal from T#%d: "
                   "task_team=%p ntasks=%d head=%u tail=%u\n",
@@ -2712,7 +2896,6 @@ static kmp_task_t *__kmp_steal_task(kmp_info_t *victim_thr, kmp_int32 gtid,
   }
 
   KMP_DEBUG_ASSERT(victim_td->td.td_deque != NULL);
-  current = __kmp_threads[gtid]->th.th_current_task;
   taskdata = victim_td->td.td_deque[victim_td->td.td_deque_head];
   if (__kmp_task_is_allowed(gtid, is_constrained, taskdata, current)) {
     // Bump head pointer and Wrap.
@@ -2859,10 +3042,17 @@ static inline int __kmp_execute_tasks_template(
             // Pick a random thread. Initial plan was to cycle through all the
             // threads, and only return if we tried to steal from every thread,
             // and failed.  Arch says that's not such a great idea.
-            victim_tid = __kmp_get_random(thread) % (nthreads - 1);
-            if (victim_tid >= tid) {
-              ++victim_tid; // Adjusts random distribution to exclude self
-            }
+            // The thread is picked among the closest ones in the machine
+            // hierarchy, and the number of candidates doubles with each
+            // failed steal, so that remote threads are only tried when no
+            // work is found nearby.
+            kmp_int32 fails = threads_data[tid].td.td_steal_fails;
+            kmp_int32 nvictims = nthreads - 1;
+            if (fails < 30 && (1 << fails) < nvictims)
+              nvictims = 1 << fails;
+            victim_tid = __kmp_get_victim_tid(
+                thread->th.th_team, tid,
+                __kmp_get_random(thread) % nvictims + 1, nthreads);
             // Found a potential victim
             other_thread = threads_data[victim_tid].td.td_thr;
             // There is a slight chance that __kmp_enable_tasking() did not wake
@@ -2896,8 +3086,11 @@ static inline int __kmp_execute_tasks_template(
           task = __kmp_steal_task(other_thread, gtid, task_team,
                                   unfinished_threads, thread_finished,
                                   is_constrained);
+          KMP_LIVE_STAT_INC(thread, task_steal_attempt);
         }
         if (task != NULL) { // set last stolen to victim
+          KMP_LIVE_STAT_INC(thread, task_steal);
+          KMP_CHECK_UPDATE(threads_data[tid].td.td_steal_fails, 0);
           if (threads_data[tid].td.td_deque_last_stolen != victim_tid) {
             threads_data[tid].td.td_deque_last_stolen = victim_tid;
             // The pre-refactored code did not try more than 1 successful new
@@ -2907,6 +3100,8 @@ static inline int __kmp_execute_tasks_template(
           }
         } else { // No tasks found; unset last_stolen
           KMP_CHECK_UPDATE(threads_data[tid].td.td_deque_last_stolen, -1);
+          if (!asleep && threads_data[tid].td.td_steal_fails < nthreads)
+            threads_data[tid].td.td_steal_fails++;
           victim_tid = -2; // no successful victim found
         }
       }
@@ -2947,7 +3142,9 @@ static inline int __kmp_execute_tasks_template(
       KMP_YIELD(__kmp_library == library_throughput); // Yield before next task
       // If execution of a stolen task results in more tasks being placed on our
       // run queue, reset use_own_tasks
-      if (!use_own_tasks && TCR_4(threads_data[tid].td.td_deque_ntasks) != 0) {
+      if (!use_own_tasks &&
+          (TCR_4(threads_data[tid].td.td_deque_ntasks) != 0 ||
+           __kmp_lf_deque_ntasks(&threads_data[tid]) != 0)) {
         KA_TRACE(20, ("__kmp_execute_tasks_template: T#%d stolen task spawned "
                       "other tasks, restart\n",
                       gtid));
@@ -3155,6 +3352,7 @@ static void __kmp_alloc_task_deque(kmp_info_t *thread,
   KMP_DEBUG_ASSERT(TCR_4(thread_data->td.td_deque_ntasks) == 0);
   KMP_DEBUG_ASSERT(thread_data->td.td_deque_head == 0);
   KMP_DEBUG_ASSERT(thread_data->td.td_deque_tail == 0);
+  KMP_DEBUG_ASSERT(__kmp_lf_deque_ntasks(thread_data) == 0);
 
   KE_TRACE(
       10,
@@ -3166,6 +3364,9 @@ static void __kmp_alloc_task_deque(kmp_info_t *thread,
   thread_data->td.td_deque = (kmp_taskdata_t **)__kmp_allocate(
       INITIAL_TASK_DEQUE_SIZE * sizeof(kmp_taskdata_t *));
   thread_data->td.td_deque_size = INITIAL_TASK_DEQUE_SIZE;
+  thread_data->td.td_lf_deque.store(
+      __kmp_alloc_lf_deque_array(INITIAL_TASK_DEQUE_SIZE),
+      std::memory_order_release);
 }
 
 // __kmp_free_task_deque:
@@ -3179,6 +3380,14 @@ static void __kmp_free_task_deque(kmp_thread_data_t *thread_data) {
     thread_data->td.td_deque = NULL;
     __kmp_release_bootstrap_lock(&thread_data->td.td_deque_lock);
   }
+  kmp_task_deque_array_t *array =
+      thread_data->td.td_lf_deque.load(std::memory_order_relaxed);
+  while (array != NULL) {
+    kmp_task_deque_array_t *prev = array->tda_prev;
+    __kmp_free(array);
+    array = prev;
+  }
+  thread_data->td.td_lf_deque.store(NULL, std::memory_order_relaxed);
 
 #ifdef BUILD_TIED_TASK_STACK
   // GEH: Figure out what to do here for td_susp_tied_tasks
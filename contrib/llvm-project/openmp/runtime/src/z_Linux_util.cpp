@@ -15,6 +15,7 @@
 #include "kmp_i18n.h"
 #include "kmp_io.h"
 #include "kmp_itt.h"
+#include "kmp_live_stats.h"
 #include "kmp_lock.h"
 #include "kmp_stats.h"
 #include "kmp_str.h"
@@ -33,19 +34,6 @@
 
 #if KMP_OS_LINUX && !KMP_OS_CNK
 #include <sys/sysinfo.h>
-#if KMP_USE_FUTEX
-// We should really include <futex.h>, but that causes compatibility problems on
-// different Linux* OS distributions that either require that you include (or
-// break when you try to include) <pci/types.h>. Since all we need is the two
-// macros below (which are part of the kernel ABI, so can't change) we just
-// define the constants here and don't include <futex.h>
-#ifndef FUTEX_WAIT
-#define FUTEX_WAIT 0
-#endif
-#ifndef FUTEX_WAKE
-#define FUTEX_WAKE 1
-#endif
-#endif
 #elif KMP_OS_DARWIN
 #include <mach/mach.h>
 #include <sys/sysctl.h>
@@ -316,7 +304,7 @@ void __kmp_affinity_determine_capable(const char *env_var) {
 
 int __kmp_futex_determine_capable() {
   int loc = 0;
-  int rc = syscall(__NR_futex, &loc, FUTEX_WAKE, 1, NULL, NULL, 0);
+  int rc = KMP_FUTEX_WAKE(&loc, 1);
   int retval = (rc == 0) || (errno != ENOSYS);
 
   KA_TRACE(10,
@@ -1354,6 +1342,8 @@ static void __kmp_atfork_child(void) {
   __kmp_itt_reset(); // reset ITT's global state
 #endif /* USE_ITT_BUILD */
 
+  __kmp_live_stats_atfork_child();
+
   /* This is necessary to make sure no stale data is left around */
   /* AC: customers complain that we use unsafe routines in the atfork
      handler. Mathworks: dlsym() is unsafe. We call dlsym and dlopen